@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+// Bump allocator for scene data. Objects are never freed individually; the
+// whole arena is released at once when the last object allocated from it is
+// destroyed (every control block holds a reference to its arena).
+//
+// Not thread-safe: scenes are decoded and their BVHs built on one thread.
+class Arena {
+public:
+    explicit Arena(size_t initial_size = 1 << 16) : resource_(initial_size) {}
+
+    Arena(const Arena &) = delete;
+    Arena& operator=(const Arena &) = delete;
+
+    void *allocate(size_t bytes, size_t alignment) {
+        bytes_allocated_ += bytes;
+        return resource_.allocate(bytes, alignment);
+    }
+
+    size_t bytes_allocated() const { return bytes_allocated_; }
+
+    // Arena used by `make_arena_shared` on this thread, if any.
+    static std::shared_ptr<Arena>& current() {
+        static thread_local std::shared_ptr<Arena> arena;
+        return arena;
+    }
+
+private:
+    std::pmr::monotonic_buffer_resource resource_;
+    size_t bytes_allocated_ = 0;
+};
+
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(std::shared_ptr<Arena> arena) : arena_(std::move(arena)) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena_) {}
+
+    T *allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+
+    void deallocate(T *, size_t) {}
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena_ == other.arena_; }
+
+private:
+    std::shared_ptr<Arena> arena_;
+
+    template<typename U>
+    friend class ArenaAllocator;
+};
+
+// Makes `arena` the current arena of this thread until the scope ends.
+class ArenaScope {
+public:
+    ArenaScope(std::shared_ptr<Arena> arena) : previous_(std::exchange(Arena::current(), std::move(arena))) {}
+    ~ArenaScope() { Arena::current() = std::move(previous_); }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope& operator=(const ArenaScope &) = delete;
+
+private:
+    std::shared_ptr<Arena> previous_;
+};
+
+// `std::make_shared` that places the object and its control block in the
+// current arena, or on the heap when no arena is active.
+template<typename T, typename... Args>
+std::shared_ptr<T> make_arena_shared(Args&&... args) {
+    if (const auto &arena = Arena::current()) {
+        return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+    }
+
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
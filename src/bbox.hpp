@@ -10,7 +10,7 @@ public:
     BBox3(const Interval &x, const Interval &y, const Interval &z) :x(x), y(y), z(z) {
         pad_to_minimums();
     }
-    BBox3(const Point3<double> &a, const Point3<double> &b) : 
+    BBox3(const Point3<real> &a, const Point3<real> &b) : 
         x((a[0] <= b[0]) ? Interval(a[0], b[0]) : Interval(b[0], a[0])),
         y((a[1] <= b[1]) ? Interval(a[1], b[1]) : Interval(b[1], a[1])),
         z((a[2] <= b[2]) ? Interval(a[2], b[2]) : Interval(b[2], a[2]))
@@ -28,13 +28,13 @@ public:
         }
     }
 
-    bool hit(const Ray<double> ray, Interval ray_t) const {
-        const Point3<double> &ray_origin = ray.origin();
-        const Vec3<double> &ray_dir = ray.direction();
+    bool hit(const Ray<real> ray, Interval ray_t) const {
+        const Point3<real> &ray_origin = ray.origin();
+        const Vec3<real> &ray_dir = ray.direction();
 
         for (int axis = 0; axis < 3; axis++) {
             const Interval& ax = axis_interval(axis);
-            const double adinv = 1.0 / ray_dir[axis];
+            const real adinv = 1.0 / ray_dir[axis];
 
             const auto t0 = (ax.min - ray_origin[axis]) * adinv;
             const auto t1 = (ax.max - ray_origin[axis]) * adinv;
@@ -67,17 +67,17 @@ public:
 
 private:
     void pad_to_minimums() {
-        double delta = 1e-4;
+        real delta = 1e-4;
         if (x.span() < delta) x = x.expand(delta);
         if (y.span() < delta) y = y.expand(delta);
         if (z.span() < delta) z = z.expand(delta);
     }
 };
 
-inline BBox3 operator+(const BBox3 &bbox, const Vec3<double> &offset) {
+inline BBox3 operator+(const BBox3 &bbox, const Vec3<real> &offset) {
     return BBox3(bbox.x + offset.x(), bbox.y + offset.y(), bbox.z + offset.z());
 }
 
-inline BBox3 operator+(const Vec3<double> &offset, const BBox3 &bbox) {
+inline BBox3 operator+(const Vec3<real> &offset, const BBox3 &bbox) {
     return bbox + offset;
 }
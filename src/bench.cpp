@@ -0,0 +1,174 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include "cpu_count.hpp"
+#include "render.hpp"
+#include "scene.hpp"
+#include "serialization.hpp"
+#include "argparse/argparse.hpp"
+
+struct BenchScene {
+    const char *name;
+    const char *file_name;
+    int32_t width, height;
+    int32_t samples_per_pixel;
+    int32_t max_depth;
+};
+
+// Fixed workloads; change them only together with the baseline results.
+static const BenchScene SCENES[] = {
+    { "bouncing_spheres", "examples/bouncing_spheres.yaml", 400, 225, 16, 10 },
+    { "cornell_box", "examples/cornell_box.yaml", 300, 300, 32, 10 },
+    { "cornell_box_smokey", "examples/cornell_box_smokey.yaml", 300, 300, 16, 10 },
+    { "showcase", "examples/showcase.yaml", 300, 300, 8, 10 },
+    { "perlin_spheres", "examples/perlin_spheres.yaml", 400, 225, 32, 10 },
+};
+
+struct BenchResult {
+    bool ok = false;
+    double load_seconds = 0, render_seconds = 0;
+    RenderStats stats;
+    long peak_rss_kb = 0;
+};
+
+// Loads and renders `scene` in the calling process.
+static BenchResult run(const BenchScene &scene, uint32_t num_threads, uint64_t seed) {
+    using Clock = std::chrono::steady_clock;
+    const auto seconds = [](auto from, auto to) { return std::chrono::duration<double>(to - from).count(); };
+
+    BenchResult result;
+    const auto start = Clock::now();
+    Scene decoded = LoadScene(scene.file_name);
+    const auto world = decoded.compile();
+    const auto loaded = Clock::now();
+
+    Image img(scene.width, scene.height);
+    RenderSettings rs(scene.samples_per_pixel, scene.max_depth);
+    rs.num_threads = num_threads;
+    rs.seed_ = seed;
+    fit_chunks(rs, img);
+
+    PersistentThreadPool pool(num_threads);
+    const auto rendering = Clock::now();
+    result.stats = render(img, decoded.camera(img), *world, rs, pool);
+    const auto done = Clock::now();
+
+    result.ok = true;
+    result.load_seconds = seconds(start, loaded);
+    result.render_seconds = seconds(rendering, done);
+
+    return result;
+}
+
+// Runs each scene in a child process so its peak RSS is its own.
+static BenchResult run_isolated(const BenchScene &scene, uint32_t num_threads, uint64_t seed) {
+    int fds[2];
+    if (::pipe(fds) != 0) return {};
+
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(fds[0]);
+        BenchResult result;
+        try {
+            result = run(scene, num_threads, seed);
+        } catch (const std::exception &err) {
+            std::cerr << scene.name << ": " << err.what() << std::endl;
+        }
+        const bool written = ::write(fds[1], &result, sizeof(result)) == sizeof(result);
+        ::_exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    ::close(fds[1]);
+    BenchResult result;
+    if (pid < 0 || ::read(fds[0], &result, sizeof(result)) != sizeof(result)) {
+        result = {};
+    }
+    ::close(fds[0]);
+
+    int status;
+    struct rusage usage;
+    if (pid > 0 && ::wait4(pid, &status, 0, &usage) == pid) {
+        result.peak_rss_kb = usage.ru_maxrss;
+    }
+
+    return result;
+}
+
+// Renders the SCENES workloads and writes wall time, throughput and peak
+// memory of each as JSON, for comparing builds over time.
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser program("bench");
+
+    program.add_argument("-n", "--num-threads")
+        .help("number of threads of execution.")
+        .scan<'i', uint32_t>();
+
+    program.add_argument("--seed")
+        .help("seed of the per-chunk random streams.")
+        .default_value(uint64_t(0))
+        .scan<'i', uint64_t>();
+
+    program.add_argument("--label")
+        .help("label stored with the results, e.g. a commit.")
+        .default_value(std::string());
+
+    program.add_argument("-o", "--output")
+        .help("JSON output file.");
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return EXIT_FAILURE;
+    }
+
+    const CpuCount &cpus = CpuCount::get();
+    std::clog << std::format("Detected {} CPUs from {}.\n", cpus.count, cpus.source);
+    const uint32_t num_threads = program.present<uint32_t>("num-threads").value_or(cpus.count);
+    const uint64_t seed = program.get<uint64_t>("seed");
+
+    std::string json = std::format("{{\n  \"label\": \"{}\",\n  \"threads\": {},\n  \"real_bits\": {},\n  \"seed\": {},\n  \"scenes\": [",
+        program.get("label"), num_threads, 8 * sizeof(real), seed);
+
+    bool ok = true;
+    for (size_t i = 0; i < std::size(SCENES); i++) {
+        const BenchScene &scene = SCENES[i];
+        const BenchResult result = run_isolated(scene, num_threads, seed);
+        ok = ok && result.ok;
+
+        const double rays_per_second = result.render_seconds > 0 ? result.stats.rays / result.render_seconds : 0;
+        const double samples_per_second = result.render_seconds > 0 ? result.stats.samples / result.render_seconds : 0;
+
+        std::clog << std::format("{:<20} {:>8.2f} s {:>8.3f} Mrays/s {:>8.3f} Msamples/s {:>8} KB{}\n",
+            scene.name, result.render_seconds, rays_per_second / 1e6, samples_per_second / 1e6, result.peak_rss_kb, result.ok ? "" : "  FAILED");
+
+        json += std::format("{}\n    {{ \"name\": \"{}\", \"ok\": {}, \"width\": {}, \"height\": {}, \"samples_per_pixel\": {}, \"max_depth\": {}, "
+            "\"load_seconds\": {:.4f}, \"render_seconds\": {:.4f}, \"rays\": {}, \"samples\": {}, "
+            "\"rays_per_second\": {:.1f}, \"samples_per_second\": {:.1f}, \"peak_rss_kb\": {} }}",
+            i == 0 ? "" : ",", scene.name, result.ok, scene.width, scene.height, scene.samples_per_pixel, scene.max_depth,
+            result.load_seconds, result.render_seconds, result.stats.rays, result.stats.samples,
+            rays_per_second, samples_per_second, result.peak_rss_kb);
+#ifdef RT_STATS
+        json.insert(json.size() - 2, std::format(", \"traversal\": {}", result.stats.traversal.json()));
+#endif
+    }
+    json += "\n  ]\n}\n";
+
+    if (auto file_name = program.present("output")) {
+        std::ofstream file(*file_name);
+        if (!(file << json)) {
+            std::cerr << "Failed to write file: " << *file_name << ".\n";
+            return EXIT_FAILURE;
+        }
+    } else {
+        std::cout << json;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
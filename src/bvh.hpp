@@ -3,10 +3,12 @@
 #include <algorithm>
 #include <memory>
 
+#include "arena.hpp"
 #include "bbox.hpp"
 #include "hittable.hpp"
 #include "hittable_list.hpp"
 #include "interval.hpp"
+#include "stats.hpp"
 
 class BVHNode : public Hittable {
 public:
@@ -34,14 +36,16 @@ public:
             std::sort(std::begin(objs) + start, std::begin(objs) + end, comparator);
 
             auto mid = start + span / 2;
-            left_ = std::make_shared<BVHNode>(objs, start, mid);
-            right_ = std::make_shared<BVHNode>(objs, mid, end);
+            left_ = make_arena_shared<BVHNode>(objs, start, mid);
+            right_ = make_arena_shared<BVHNode>(objs, mid, end);
         }
     }
 
     BVHNode(std::shared_ptr<Hittable> left, std::shared_ptr<Hittable> right) : left_(left), right_(right), bbox_(BBox3(left->bounding_box(), right->bounding_box())) {}
 
-    bool hit(const Ray<double> &ray, Interval ray_t, HitRecord &rec) const override {
+    bool hit(const Ray<real> &ray, Interval ray_t, HitRecord &rec) const override {
+        RT_STAT(nodes_visited++);
+        RT_STAT(aabb_tests++);
         if (!bbox_.hit(ray, ray_t)) return false;
 
         bool hit_left = left_->hit(ray, ray_t, rec);
@@ -80,4 +84,5 @@ private:
     BBox3 bbox_;
 
     friend struct YAML::convert<std::shared_ptr<BVHNode>>;
+    friend class CompiledScene;
 };
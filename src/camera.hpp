@@ -9,13 +9,13 @@
 
 class Camera {
 public:
-    Camera(Point3<double> center,
-            double defocus_angle,
-            Vec3<double> pixel_delta_u,
-            Vec3<double> pixel_delta_v,
-            Vec3<double> pixel00_loc,
-            Vec3<double> defocus_disk_u,
-            Vec3<double> defocus_disk_v,
+    Camera(Point3<real> center,
+            real defocus_angle,
+            Vec3<real> pixel_delta_u,
+            Vec3<real> pixel_delta_v,
+            Vec3<real> pixel00_loc,
+            Vec3<real> defocus_disk_u,
+            Vec3<real> defocus_disk_v,
             Color background) : 
         background_(background),
         center_(center),
@@ -27,30 +27,30 @@ public:
         defocus_disk_v_(defocus_disk_v)
     {}
 
-    Ray<double> cast_ray_at_pixel_loc(size_t row, size_t col) const {
+    Ray<real> cast_ray_at_pixel_loc(size_t row, size_t col) const {
         const auto offset = sample_square();
-        const Point3<double> pixel_center = pixel00_loc_ + ((row + offset.x()) * pixel_delta_v_) + ((col + offset.y()) * pixel_delta_u_);
+        const Point3<real> pixel_center = pixel00_loc_ + ((row + offset.x()) * pixel_delta_v_) + ((col + offset.y()) * pixel_delta_u_);
         const auto ray_origin = (defocus_angle_ <= 0) ? center_ : defocus_disk_sample();
-        const Vec3<double> ray_direction = pixel_center - ray_origin;
+        const Vec3<real> ray_direction = pixel_center - ray_origin;
         const auto ray_time = random_double();
 
-        return Ray<double>(ray_origin, ray_direction, ray_time);
+        return Ray<real>(ray_origin, ray_direction, ray_time);
     }
 
     Color background_;
 
 private:
-    Point3<double> center_;
-    double defocus_angle_;
-    Vec3<double> pixel_delta_u_, pixel_delta_v_;
-    Vec3<double> pixel00_loc_;
-    Vec3<double> defocus_disk_u_, defocus_disk_v_;
+    Point3<real> center_;
+    real defocus_angle_;
+    Vec3<real> pixel_delta_u_, pixel_delta_v_;
+    Vec3<real> pixel00_loc_;
+    Vec3<real> defocus_disk_u_, defocus_disk_v_;
 
-    Vec3<double> sample_square() const {
-        return Vec3<double>(0.5 - random_double(), 0.5 - random_double(), 0.0);
+    Vec3<real> sample_square() const {
+        return Vec3<real>(0.5 - random_double(), 0.5 - random_double(), 0.0);
     }
 
-    Point3<double> defocus_disk_sample() const {
+    Point3<real> defocus_disk_sample() const {
         const auto p = random_on_unit_disk();
         return center_ + (p.x() * defocus_disk_u_) + (p.y() * defocus_disk_v_);
     }
@@ -65,7 +65,7 @@ public:
         const auto theta = degrees_to_radians(vfov_);
         const auto h = std::tan(theta / 2.0);
         const auto viewport_height = 2 * h * focus_dist_;
-        const auto viewport_width = viewport_height * static_cast<double>(img.width_) / img.height_;
+        const auto viewport_width = viewport_height * static_cast<real>(img.width_) / img.height_;
         const auto w = normalize(lookfrom_ - lookat_);
         const auto u = normalize(cross(vup_, w));
         const auto v = cross(w, u);
@@ -82,11 +82,11 @@ public:
         return Camera(lookfrom_, defocus_angle_, pixel_delta_u, pixel_delta_v, pixel00_loc, defocus_disk_u, defocus_disk_v, background_);
     }
 
-    Point3<double> lookfrom_ = Point3<double>();
-    Point3<double> lookat_ = Point3<double>(0.0, 0.0, -1.0);
-    double vfov_ = 90.0;
-    Vec3<double> vup_ = Vec3<double>(0.0, 1.0, 0.0);
-    double defocus_angle_ = 0.0;
-    double focus_dist_ = 10.0;
+    Point3<real> lookfrom_ = Point3<real>();
+    Point3<real> lookat_ = Point3<real>(0.0, 0.0, -1.0);
+    real vfov_ = 90.0;
+    Vec3<real> vup_ = Vec3<real>(0.0, 1.0, 0.0);
+    real defocus_angle_ = 0.0;
+    real focus_dist_ = 10.0;
     Color background_ = Color();
 };
@@ -6,16 +6,16 @@
 //
 //     const auto checker_tex = std::make_shared<CheckerTexture>(0.32, Color(0.2, 0.3, 0.1), Color(0.9, 0.9, 0.9));
 //
-//     scene.add(std::make_shared<Sphere>(Point3<double>(0, -10, 0), 10, std::make_shared<Lambertian>(checker_tex)));
-//     scene.add(std::make_shared<Sphere>(Point3<double>(0, 10, 0), 10, std::make_shared<Lambertian>(checker_tex)));
+//     scene.add(std::make_shared<Sphere>(Point3<real>(0, -10, 0), 10, std::make_shared<Lambertian>(checker_tex)));
+//     scene.add(std::make_shared<Sphere>(Point3<real>(0, 10, 0), 10, std::make_shared<Lambertian>(checker_tex)));
 //
 //     RenderSettings rs(100, 50);
 //
 //     CameraBuilder cb;
 //     cb.vfov_ = 20;
-//     cb.lookfrom_ = Point3<double>(13, 2, 3);
-//     cb.lookat_ = Point3<double>(0, 0, 0);
-//     cb.vup_ = Vec3<double>(0, 1, 0);
+//     cb.lookfrom_ = Point3<real>(13, 2, 3);
+//     cb.lookat_ = Point3<real>(0, 0, 0);
+//     cb.vup_ = Vec3<real>(0, 1, 0);
 //     cb.defocus_angle_ = 0;
 //
 //     const Camera cam(cb.build(img));
@@ -35,8 +35,8 @@ int main() {
     scene.add_material(mat);
 
     
-    scene.add_object(std::make_shared<Sphere>(Point3<double>(0, -10, 0), 10, mat));
-    scene.add_object(std::make_shared<Sphere>(Point3<double>(0, 10, 0), 10, mat));
+    scene.add_object(std::make_shared<Sphere>(Point3<real>(0, -10, 0), 10, mat));
+    scene.add_object(std::make_shared<Sphere>(Point3<real>(0, 10, 0), 10, mat));
 
     std::cout << scene << '\n';
 }
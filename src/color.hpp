@@ -5,11 +5,12 @@
 #include <type_traits>
 #include <iostream>
 #include "interval.hpp"
+#include "simd.hpp"
 #include "vec3.hpp"
 
-static const Interval intensity(0, std::nexttoward(1.0, 0.0));
+static const Interval intensity(0, std::nexttoward(real(1), 0.0L));
 
-inline double linear_to_gamma(double x) {
+inline real linear_to_gamma(real x) {
     if (x > 0.0) {
         return std::sqrt(x);
     }
@@ -18,42 +19,54 @@ inline double linear_to_gamma(double x) {
 }
 
 struct Color {
-    double elem[3];
+    vec3_storage_t<real> elem;
 
     Color() : elem{0, 0, 0} { }
 
+#ifdef RT_SIMD
+    explicit Color(simd::lanes_t<real> v) : elem(v) {}
+#endif
+
     template<typename Integer, std::enable_if_t<std::is_integral<Integer>::value, bool> = true>
     Color(Integer r, Integer g, Integer b) : elem{
-        r / 256.0,
-        g / 256.0,
-        b / 256.0
+        r / real(256),
+        g / real(256),
+        b / real(256)
     } {}
 
     template<typename Floating, std::enable_if_t<std::is_floating_point<Floating>::value, bool> = true>
-    Color(Floating r, Floating g, Floating b) : elem{ r, g, b } {}
+    Color(Floating r, Floating g, Floating b) : elem{ static_cast<real>(r), static_cast<real>(g), static_cast<real>(b) } {}
 
     template<typename Integer, std::enable_if_t<std::is_integral<Integer>::value, bool> = true>
     Color(const Vec3<Integer> &v) : elem{
-        v.x() / 256.0,
-        v.y() / 256.0,
-        v.z() / 256.0
+        v.x() / real(256),
+        v.y() / real(256),
+        v.z() / real(256)
     } {}
 
     template<typename Floating, std::enable_if_t<std::is_floating_point<Floating>::value, bool> = true>
-    Color(const Vec3<Floating> &v) : elem{ v.x(), v.y(), v.z() } {}
+    Color(const Vec3<Floating> &v) : elem{ static_cast<real>(v.x()), static_cast<real>(v.y()), static_cast<real>(v.z()) } {}
 
     inline uint32_t r_int() const { return 256 * intensity.clamp(linear_to_gamma(elem[0])); }
     inline uint32_t g_int() const { return 256 * intensity.clamp(linear_to_gamma(elem[1])); }
     inline uint32_t b_int() const { return 256 * intensity.clamp(linear_to_gamma(elem[2])); }
 
-    inline double r() const { return elem[0]; }
-    inline double g() const { return elem[1]; }
-    inline double b() const { return elem[2]; }
+    inline real r() const { return elem[0]; }
+    inline real g() const { return elem[1]; }
+    inline real b() const { return elem[2]; }
+
+#ifdef RT_SIMD
+    simd::lanes_t<real> lanes() const { return elem; }
+#endif
 
     Color& operator+=(const Color& other) {
+#ifdef RT_SIMD
+        elem += other.elem;
+#else
         this->elem[0] += other.elem[0];
         this->elem[1] += other.elem[1];
         this->elem[2] += other.elem[2];
+#endif
 
         return *this;
     }
@@ -62,13 +75,13 @@ struct Color {
         return Color(random_double(), random_double(), random_double());
     }
 
-    static Color random(double min, double max) {
+    static Color random(real min, real max) {
         return Color(random_double(min, max), random_double(min, max), random_double(min, max));
     }
 };
 
 template<>
-inline Vec3<double>::Vec3(const Color &c) : elem{c.r(), c.g(), c.b()} {}
+inline Vec3<real>::Vec3(const Color &c) : elem{c.r(), c.g(), c.b()} {}
 
 inline std::ostream& operator<<(std::ostream& out, const Color color) {
     return out << color.r_int() << ' ' << color.g_int() << ' ' << color.b_int();
@@ -76,16 +89,30 @@ inline std::ostream& operator<<(std::ostream& out, const Color color) {
 
 template<typename T>
 Color operator*(Color c, T t) {
+#ifdef RT_SIMD
+    return Color(c.lanes() * static_cast<real>(t));
+#else
     return Color(c.elem[0] * t, c.elem[1] * t, c.elem[2] * t);
+#endif
 }
 
 template<typename T>
 Color operator*(T t, Color c) { return c * t; }
 
 inline Color operator*(Color a, Color b) {
+#ifdef RT_SIMD
+    return Color(a.lanes() * b.lanes());
+#else
     return Color(a.elem[0] * b.elem[0], a.elem[1] * b.elem[1], a.elem[2] * b.elem[2]);
+#endif
 }
 
-inline Color operator+(Color a, Color b) { return Color(Vec3<double>(a) + Vec3<double>(b)); }
+inline Color operator+(Color a, Color b) {
+#ifdef RT_SIMD
+    return Color(a.lanes() + b.lanes());
+#else
+    return Color(a.elem[0] + b.elem[0], a.elem[1] + b.elem[1], a.elem[2] + b.elem[2]);
+#endif
+}
 
 inline bool operator==(Color a, Color b) { return a.elem[0] == b.elem[0] && a.elem[1] == b.elem[1] && a.elem[2] == b.elem[2]; }
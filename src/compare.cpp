@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "image.hpp"
+#include "image_metrics.hpp"
+#include "argparse/argparse.hpp"
+
+static bool is_linear(const std::filesystem::path &file_name) {
+    return file_name.extension() == ".pfm";
+}
+
+// Reads a PPM, or a PFM converted to display values unless `space` is
+// linear. Throws `std::runtime_error` if the file can't be read.
+static Image read_image(const std::filesystem::path &file_name, PixelSpace space) {
+    Image img;
+    if (is_linear(file_name)) {
+        std::ifstream file(file_name, std::ios::binary);
+        if (img.read_pfm(file)) return space == PixelSpace::Linear ? img : to_display(img);
+    } else {
+        std::ifstream file(file_name);
+        if (file >> img) return img;
+    }
+
+    throw std::runtime_error(std::format("Failed to read image: {}.", file_name.string()));
+}
+
+struct Snapshot {
+    uint32_t samples;
+    double seconds;
+    std::filesystem::path file_name;
+};
+
+// Reads the snapshots.csv written by `main --snapshots`. Image paths are
+// relative to the CSV.
+static std::vector<Snapshot> read_snapshots(const std::filesystem::path &file_name) {
+    std::ifstream file(file_name);
+    std::string line;
+    if (!std::getline(file, line)) {
+        throw std::runtime_error(std::format("Failed to read snapshots: {}.", file_name.string()));
+    }
+
+    std::vector<Snapshot> snapshots;
+    while (std::getline(file, line)) {
+        std::istringstream row(line);
+        std::string pass, samples, seconds, image;
+        if (!(std::getline(row, pass, ',') && std::getline(row, samples, ',') && std::getline(row, seconds, ',') && std::getline(row, image))) {
+            throw std::runtime_error(std::format("Malformed snapshot line in {}: {}.", file_name.string(), line));
+        }
+        snapshots.push_back({ static_cast<uint32_t>(std::stoul(samples)), std::stod(seconds), file_name.parent_path() / image });
+    }
+
+    return snapshots;
+}
+
+// Plots relMSE against time on log-log axes, one row per snapshot.
+static void plot_curve(std::ostream &out, const std::vector<Snapshot> &snapshots, const std::vector<ImageError> &errors) {
+    constexpr int WIDTH = 60;
+
+    double lo = INFINITY, hi = 0;
+    for (const auto &err : errors) {
+        if (err.relmse > 0) {
+            lo = std::min(lo, err.relmse);
+            hi = std::max(hi, err.relmse);
+        }
+    }
+    if (hi == 0) return;
+
+    const double range = std::max(std::log10(hi / lo), 1e-9);
+    out << std::format("{:>10}  relMSE {:.2e} {:>{}}\n", "seconds", lo, std::format("{:.2e}", hi), WIDTH - 17);
+    for (size_t i = 0; i < snapshots.size(); i++) {
+        const int bar = errors[i].relmse > 0 ? static_cast<int>(std::round(WIDTH * std::log10(errors[i].relmse / lo) / range)) : 0;
+        out << std::format("{:>10.3f}  |{}*\n", snapshots[i].seconds, std::string(bar, ' '));
+    }
+}
+
+// Reports how far `image` is from `reference`. When both are PFMs the errors
+// are measured on their linear values, so errors above 1 around bright lights
+// count in full; otherwise on display values (gamma-encoded and clamped, as
+// written to a PPM). FLIP always compares display values. Exits with failure
+// when a --max-* tolerance is exceeded.
+//
+// Given the snapshots.csv of a progressive render instead of an image, prints
+// the error of every snapshot against the time it took, to compare how fast
+// two samplers or builds converge.
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser program("compare");
+
+    program.add_argument("reference")
+        .help("reference image, PPM or PFM.");
+
+    program.add_argument("image")
+        .help("image to compare against the reference, PPM or PFM, or a snapshots.csv.");
+
+    program.add_argument("--ppd")
+        .help("pixels per degree of visual angle, for FLIP.")
+        .default_value(DEFAULT_PIXELS_PER_DEGREE)
+        .scan<'g', double>();
+
+    program.add_argument("--flip-map")
+        .help("write the per-pixel FLIP error to this PPM.");
+
+    program.add_argument("--max-rmse")
+        .help("fail if the RMSE is above this.")
+        .scan<'g', double>();
+
+    program.add_argument("--max-relmse")
+        .help("fail if the relative MSE is above this.")
+        .scan<'g', double>();
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return EXIT_FAILURE;
+    }
+
+    const double ppd = program.get<double>("ppd");
+    const std::filesystem::path reference_name = program.get("reference");
+    const std::filesystem::path image_name = program.get("image");
+    // The space of comparing `reference` with the image `name`.
+    const auto space_of = [&](const std::filesystem::path &name) {
+        return is_linear(reference_name) && is_linear(name) ? PixelSpace::Linear : PixelSpace::Display;
+    };
+    const auto describe = [](PixelSpace space) {
+        return std::format("Errors on {} values, FLIP on display values.", space == PixelSpace::Linear ? "linear" : "display");
+    };
+    try {
+        const Image linear_reference = is_linear(reference_name) ? read_image(reference_name, PixelSpace::Linear) : Image();
+        const Image reference = read_image(reference_name, PixelSpace::Display);
+        // The reference in the space of comparing it with `name`.
+        const auto reference_for = [&](const std::filesystem::path &name) -> const Image& {
+            return space_of(name) == PixelSpace::Linear ? linear_reference : reference;
+        };
+        const auto check_size = [&](const Image &image) {
+            if (reference.width_ != image.width_ || reference.height_ != image.height_) {
+                throw std::runtime_error(std::format("Image sizes differ: {}x{} and {}x{}.", reference.width_, reference.height_, image.width_, image.height_));
+            }
+        };
+
+        if (image_name.extension() == ".csv") {
+            const auto snapshots = read_snapshots(image_name);
+            std::vector<ImageError> errors;
+            if (!snapshots.empty()) {
+                std::cerr << describe(space_of(snapshots.front().file_name)) << '\n';
+            }
+            std::cout << "samples,seconds,rmse,relmse,psnr,flip\n";
+            for (const auto &snapshot : snapshots) {
+                const PixelSpace space = space_of(snapshot.file_name);
+                const Image image = read_image(snapshot.file_name, space);
+                check_size(image);
+                const ImageError &err = errors.emplace_back(compare_images(reference_for(snapshot.file_name), image, ppd, space));
+                std::cout << std::format("{},{:.3f},{:.6f},{:.6f},{:.2f},{:.6f}\n", snapshot.samples, snapshot.seconds, err.rmse, err.relmse, err.psnr, err.flip);
+            }
+            plot_curve(std::cerr, snapshots, errors);
+            return EXIT_SUCCESS;
+        }
+
+        const PixelSpace space = space_of(image_name);
+        const Image image = read_image(image_name, space);
+        check_size(image);
+        const ImageError err = compare_images(reference_for(image_name), image, ppd, space);
+
+        std::cout << describe(space) << '\n';
+
+        std::cout << std::format("RMSE: {:.6f}\n", err.rmse);
+        std::cout << std::format("relMSE: {:.6f}\n", err.relmse);
+        std::cout << std::format("PSNR: {:.2f} dB\n", err.psnr);
+        std::cout << std::format("FLIP: {:.6f}\n", err.flip);
+        std::cout << std::format("Max:  {:.6f}\n", err.max);
+        std::cout << std::format("Bias: {:+.6f}\n", err.bias);
+
+        if (program.present("flip-map")) {
+            // Squared to undo the gamma applied when writing.
+            Image map = flip_error(reference, space == PixelSpace::Linear ? to_display(image) : image, ppd);
+            for (auto &row : map.pixels_) {
+                for (auto &pixel : row) {
+                    pixel = Color(pixel.r() * pixel.r(), pixel.g() * pixel.g(), pixel.b() * pixel.b());
+                }
+            }
+            std::ofstream file(program.get("flip-map"));
+            file << map;
+        }
+
+        bool ok = true;
+        if (auto max_rmse = program.present<double>("max-rmse"); max_rmse && err.rmse > *max_rmse) {
+            std::cerr << std::format("RMSE {:.6f} exceeds {:.6f}.\n", err.rmse, *max_rmse);
+            ok = false;
+        }
+        if (auto max_relmse = program.present<double>("max-relmse"); max_relmse && err.relmse > *max_relmse) {
+            std::cerr << std::format("relMSE {:.6f} exceeds {:.6f}.\n", err.relmse, *max_relmse);
+            ok = false;
+        }
+
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
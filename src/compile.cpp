@@ -0,0 +1,38 @@
+#include <cstdlib>
+#include <iostream>
+#include "scene.hpp"
+#include "scene_file.hpp"
+#include "serialization.hpp"
+#include "argparse/argparse.hpp"
+
+// Compiles a YAML scene into a scene file that `main` maps directly, skipping
+// YAML decoding and the BVH build.
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser program("compile");
+
+    program.add_argument("scene")
+        .help("YAML file specifying the scene.");
+
+    program.add_argument("-o", "--output")
+        .help("output scene file.")
+        .required();
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        Scene scene = LoadScene(program.get("scene"));
+        const auto compiled = scene.compile();
+        SceneFile::write(program.get("output"), *compiled, scene.cb_);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
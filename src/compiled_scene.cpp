@@ -0,0 +1,564 @@
+#include "compiled_scene.hpp"
+#include "bvh.hpp"
+#include "constant_medium.hpp"
+#include "hittable_list.hpp"
+#include "instance.hpp"
+#include "quad.hpp"
+#include "simd.hpp"
+#include "sphere.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <typeinfo>
+
+static_assert(static_cast<size_t>(CompiledScene::PrimType::Other) == TraversalStats::OTHER, "Primitive test counters are indexed by PrimType.");
+
+CompiledScene::CompiledScene(const std::vector<std::shared_ptr<Hittable>> &objs) {
+    TraceScope trace("build BVH", "load");
+    root_ = compile(objs);
+
+    subtree_roots_.clear();
+    material_indices_.clear();
+
+    nodes_ = arrays_.nodes;
+    spheres_ = arrays_.spheres;
+    quads_ = arrays_.quads;
+    transforms_ = arrays_.transforms;
+    media_ = arrays_.media;
+}
+
+uint32_t CompiledScene::compile(const std::vector<std::shared_ptr<Hittable>> &objs) {
+    Staging staging;
+    for (const auto &obj : objs) {
+        gather(obj, staging);
+    }
+
+    return build(staging, 0, staging.refs.size());
+}
+
+uint32_t CompiledScene::compile_subtree(const std::shared_ptr<Hittable> &obj) {
+    const auto it = subtree_roots_.find(obj.get());
+    if (it != subtree_roots_.end()) {
+        return it->second;
+    }
+
+    const uint32_t root = compile({obj});
+    subtree_roots_[obj.get()] = root;
+
+    return root;
+}
+
+void CompiledScene::gather(const std::shared_ptr<Hittable> &obj, Staging &staging) {
+    const Hittable &ref = *obj;
+    const auto &type = typeid(ref);
+
+    if (type == typeid(HittableList)) {
+        for (const auto &child : static_cast<const HittableList&>(ref).objs) {
+            gather(child, staging);
+        }
+    } else if (type == typeid(BVHNode)) {
+        const auto &node = static_cast<const BVHNode&>(ref);
+        gather(node.left_, staging);
+        if (node.right_ != node.left_) {
+            gather(node.right_, staging);
+        }
+    } else if (type == typeid(Sphere)) {
+        const auto &sphere = static_cast<const Sphere&>(ref);
+        staging.refs.push_back({PrimType::Sphere, static_cast<uint32_t>(staging.spheres.size()), sphere.bbox_});
+        staging.spheres.push_back({sphere.origin_.origin(), sphere.origin_.direction(), sphere.radius_, material_index(sphere.mat_)});
+    } else if (type == typeid(Quad)) {
+        const auto &quad = static_cast<const Quad&>(ref);
+        add_quad(quad.origin_, quad.u_, quad.v_, quad.mat_, quad.bbox_, staging);
+    } else if (type == typeid(Box)) {
+        for (const auto &side : static_cast<const Box&>(ref).sides_.objs) {
+            gather(side, staging);
+        }
+    } else if (type == typeid(Translate)) {
+        const auto &translate = static_cast<const Translate&>(ref);
+        add_transform(translate.object_, Transform::translate(translate.offset_), translate.bbox_, staging);
+    } else if (type == typeid(RotateY)) {
+        const auto &rotate = static_cast<const RotateY&>(ref);
+        add_transform(rotate.object_, Transform::rotate_y(radians_to_degrees(rotate.theta_)), rotate.bbox_, staging);
+    } else if (type == typeid(Instance)) {
+        const auto &instance = static_cast<const Instance&>(ref);
+        add_transform(instance.object(), instance.transform(), instance.bounding_box(), staging);
+    } else if (type == typeid(ConstantMedium)) {
+        const auto &medium = static_cast<const ConstantMedium&>(ref);
+        const uint32_t boundary = compile_subtree(medium.boundary_);
+        staging.refs.push_back({PrimType::Medium, static_cast<uint32_t>(staging.media.size()), medium.bounding_box()});
+        staging.media.push_back({boundary, medium.neg_inv_density_, material_index(medium.phase_function_)});
+    } else {
+        staging.refs.push_back({PrimType::Other, static_cast<uint32_t>(staging.others.size()), obj->bounding_box()});
+        staging.others.push_back(obj);
+    }
+}
+
+void CompiledScene::add_quad(const Point3<real> &origin, const Vec3<real> &u, const Vec3<real> &v, const std::shared_ptr<Material> &mat, const BBox3 &bbox, Staging &staging) {
+    const auto n = cross(u, v);
+    const auto normal = normalize(n);
+
+    staging.refs.push_back({PrimType::Quad, static_cast<uint32_t>(staging.quads.size()), bbox});
+    staging.quads.push_back({origin, u, v, n / dot(n, n), normal, dot(normal, Vec3<real>(origin)), material_index(mat)});
+}
+
+void CompiledScene::add_transform(const std::shared_ptr<Hittable> &child, const Transform &xf, const BBox3 &bbox, Staging &staging) {
+    const uint32_t root = compile_subtree(child);
+
+    staging.refs.push_back({PrimType::Transform, static_cast<uint32_t>(staging.transforms.size()), bbox});
+    staging.transforms.push_back({xf, root});
+}
+
+uint32_t CompiledScene::material_index(const std::shared_ptr<Material> &mat) {
+    const auto it = material_indices_.find(mat.get());
+    if (it != material_indices_.end()) {
+        return it->second;
+    }
+
+    const auto index = static_cast<uint32_t>(materials_.size());
+    materials_.push_back(mat);
+    material_indices_[mat.get()] = index;
+
+    return index;
+}
+
+uint32_t CompiledScene::build(Staging &staging, size_t start, size_t end) {
+    const auto node_index = static_cast<uint32_t>(arrays_.nodes.size());
+    arrays_.nodes.push_back(Node{BBox3::empty, 0, 0, PrimType::Other, 0});
+
+    auto bbox = BBox3::empty;
+    for (size_t i = start; i < end; i++) {
+        bbox = BBox3(bbox, staging.refs[i].bbox);
+    }
+    arrays_.nodes[node_index].bbox = bbox;
+
+    const auto begin = std::begin(staging.refs);
+    const size_t span = end - start;
+    const bool uniform = std::all_of(begin + start, begin + end, [&](const PrimRef &ref) { return ref.type == staging.refs[start].type; });
+
+    if (span <= MAX_LEAF_SIZE && uniform) {
+        emit_leaf(staging, start, end, arrays_.nodes[node_index]);
+        return node_index;
+    }
+
+    const int axis = bbox.longest_axis();
+    size_t mid = start + span / 2;
+
+    if (span <= MAX_LEAF_SIZE) {
+        // Small but mixed: split at the first change of primitive type.
+        std::sort(begin + start, begin + end, [](const PrimRef &a, const PrimRef &b) { return a.type < b.type; });
+        mid = start + 1;
+        while (staging.refs[mid].type == staging.refs[start].type) mid++;
+    } else {
+        std::sort(begin + start, begin + end, [axis](const PrimRef &a, const PrimRef &b) {
+            return a.bbox.axis_interval(axis).min < b.bbox.axis_interval(axis).min;
+        });
+    }
+
+    build(staging, start, mid);
+    const uint32_t right = build(staging, mid, end);
+
+    arrays_.nodes[node_index].offset = right;
+    arrays_.nodes[node_index].axis = static_cast<uint8_t>(axis);
+
+    return node_index;
+}
+
+void CompiledScene::emit_leaf(Staging &staging, size_t start, size_t end, Node &node) {
+    node.count = static_cast<uint16_t>(end - start);
+    node.type = end > start ? staging.refs[start].type : PrimType::Other;
+
+    for (size_t i = start; i < end; i++) {
+        const auto index = staging.refs[i].index;
+        uint32_t offset = 0;
+
+        switch (node.type) {
+            case PrimType::Sphere:
+                offset = arrays_.spheres.size();
+                arrays_.spheres.push_back(staging.spheres[index]);
+                break;
+            case PrimType::Quad:
+                offset = arrays_.quads.size();
+                arrays_.quads.push_back(staging.quads[index]);
+                break;
+            case PrimType::Transform:
+                offset = arrays_.transforms.size();
+                arrays_.transforms.push_back(staging.transforms[index]);
+                break;
+            case PrimType::Medium:
+                offset = arrays_.media.size();
+                arrays_.media.push_back(staging.media[index]);
+                break;
+            case PrimType::Other:
+                offset = others_.size();
+                others_.push_back(staging.others[index]);
+                break;
+        }
+
+        if (i == start) {
+            node.offset = offset;
+        }
+    }
+}
+
+bool CompiledScene::hit_tree(uint32_t root, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const {
+    uint32_t stack[STACK_SIZE];
+    int32_t stack_size = 0;
+    stack[stack_size++] = root;
+
+    bool hit_anything = false;
+
+    while (stack_size > 0) {
+        const Node &node = nodes_[stack[--stack_size]];
+
+        RT_STAT(nodes_visited++);
+        RT_STAT(aabb_tests++);
+        if (!node.bbox.hit(ray, ray_t)) continue;
+
+        if (node.count > 0) {
+            if (hit_leaf(node, ray, ray_t, rec)) {
+                hit_anything = true;
+                ray_t.max = rec.t;
+            }
+        } else if (node.offset != 0) {
+            // Interior node (a right child always follows its parent, so an
+            // empty leaf is the only node with neither primitives nor offset).
+            // Visit the child nearer along the split axis first.
+            const uint32_t left = static_cast<uint32_t>(&node - nodes_.data()) + 1;
+            if (ray.direction()[node.axis] < 0) {
+                stack[stack_size++] = left;
+                stack[stack_size++] = node.offset;
+            } else {
+                stack[stack_size++] = node.offset;
+                stack[stack_size++] = left;
+            }
+        }
+    }
+
+    return hit_anything;
+}
+
+void CompiledScene::hit_packet(const Ray<real> *rays, size_t count, Interval ray_t, HitRecord *recs, bool *hits) const {
+    assert(count <= PACKET_SIZE);
+
+    // Unused lanes repeat the first ray with an empty interval.
+    Packet packet;
+    for (size_t i = 0; i < PACKET_SIZE; i++) {
+        const Ray<real> &ray = rays[i < count ? i : 0];
+        for (int axis = 0; axis < 3; axis++) {
+            packet.origin[axis][i] = ray.origin()[axis];
+            packet.dir[axis][i] = ray.direction()[axis];
+            packet.inv_dir[axis][i] = 1.0 / ray.direction()[axis];
+        }
+        packet.time[i] = ray.time();
+        packet.t_max[i] = i < count ? ray_t.max : -infinity;
+        packet.deferred[i] = false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        hits[i] = false;
+    }
+
+    uint32_t stack[STACK_SIZE];
+    int32_t stack_size = 0;
+    stack[stack_size++] = root_;
+
+    while (stack_size > 0) {
+        const Node &node = nodes_[stack[--stack_size]];
+
+        RT_STAT(nodes_visited++);
+        RT_STAT(aabb_tests += count);
+        if (!hit_box_packet(node.bbox, ray_t.min, packet)) continue;
+
+        if (node.count > 0) {
+            switch (node.type) {
+                case PrimType::Sphere:
+                    RT_STAT(primitive_tests[TraversalStats::SPHERE] += node.count * count);
+                    hit_spheres_packet(node, ray_t.min, packet);
+                    break;
+                case PrimType::Quad:
+                    RT_STAT(primitive_tests[TraversalStats::QUAD] += node.count * count);
+                    hit_quads_packet(node, ray_t.min, packet);
+                    break;
+                default:
+                    for (size_t i = 0; i < count; i++) {
+                        if (packet.active[i] && hit_leaf(node, rays[i], Interval(ray_t.min, packet.t_max[i]), recs[i])) {
+                            hits[i] = true;
+                            packet.t_max[i] = recs[i].t;
+                            packet.deferred[i] = false;
+                        }
+                    }
+                    break;
+            }
+        } else if (node.offset != 0) {
+            // Order the children for the first ray; the rest of a coherent
+            // packet mostly agrees with it.
+            const uint32_t left = static_cast<uint32_t>(&node - nodes_.data()) + 1;
+            if (rays[0].direction()[node.axis] < 0) {
+                stack[stack_size++] = left;
+                stack[stack_size++] = node.offset;
+            } else {
+                stack[stack_size++] = node.offset;
+                stack[stack_size++] = left;
+            }
+        }
+    }
+
+    // Re-running the winning test with an open interval picks the same root.
+    for (size_t i = 0; i < count; i++) {
+        if (!packet.deferred[i]) continue;
+
+        const Interval t(ray_t.min, infinity);
+        if (packet.best_type[i] == PrimType::Sphere) {
+            hits[i] = hit_sphere(spheres_[packet.best[i]], rays[i], t, recs[i]);
+        } else {
+            hits[i] = hit_quad(quads_[packet.best[i]], rays[i], t, recs[i]);
+        }
+    }
+}
+
+using SlabLanes = simd::register_t<real>;
+constexpr size_t SLAB_LANES = sizeof(SlabLanes) / sizeof(real);
+
+static inline SlabLanes load_lanes(const real *p) {
+    SlabLanes v;
+    std::memcpy(&v, p, sizeof(SlabLanes));
+    return v;
+}
+
+// One slab of the packet box test on a group of lanes. The GCC vector
+// selects compile to packed min and max.
+static inline void clip_slab(const Interval &ax, const real *origin, const real *inv_dir, SlabLanes &lo, SlabLanes &hi) {
+    const SlabLanes o = load_lanes(origin);
+    const SlabLanes inv = load_lanes(inv_dir);
+    const SlabLanes t0 = (ax.min - o) * inv;
+    const SlabLanes t1 = (ax.max - o) * inv;
+    const SlabLanes near = t0 < t1 ? t0 : t1;
+    const SlabLanes far = t0 < t1 ? t1 : t0;
+    lo = near > lo ? near : lo;
+    hi = far < hi ? far : hi;
+}
+
+// Slab test of every lane, with the same comparisons as `BBox3::hit` so a
+// packet visits exactly the nodes its rays would visit one at a time.
+bool CompiledScene::hit_box_packet(const BBox3 &bbox, real t_min, Packet &packet) const {
+    static_assert(PACKET_SIZE % SLAB_LANES == 0);
+
+    bool any = false;
+    for (size_t base = 0; base < PACKET_SIZE; base += SLAB_LANES) {
+        SlabLanes lo = SlabLanes{} + t_min;
+        SlabLanes hi = load_lanes(packet.t_max + base);
+
+        clip_slab(bbox.x, packet.origin[0] + base, packet.inv_dir[0] + base, lo, hi);
+        clip_slab(bbox.y, packet.origin[1] + base, packet.inv_dir[1] + base, lo, hi);
+        clip_slab(bbox.z, packet.origin[2] + base, packet.inv_dir[2] + base, lo, hi);
+
+        const auto active = lo < hi;
+        for (size_t i = 0; i < SLAB_LANES; i++) {
+            packet.active[base + i] = active[i] != 0;
+            any |= packet.active[base + i];
+        }
+    }
+
+    return any;
+}
+
+// Lane-wise `hit_sphere` up to the choice of root, evaluated in the same order.
+void CompiledScene::hit_spheres_packet(const Node &node, real t_min, Packet &packet) const {
+    const uint32_t end = node.offset + node.count;
+    for (uint32_t s = node.offset; s < end; s++) {
+        const SphereData &sphere = spheres_[s];
+        const real radius_sqr = sphere.radius * sphere.radius;
+
+        for (size_t i = 0; i < PACKET_SIZE; i++) {
+            real diff[3];
+            for (int axis = 0; axis < 3; axis++) {
+                diff[axis] = (sphere.center[axis] + sphere.velocity[axis] * packet.time[i]) - packet.origin[axis][i];
+            }
+
+            const real dx = packet.dir[0][i], dy = packet.dir[1][i], dz = packet.dir[2][i];
+            const real a = dx * dx + dy * dy + dz * dz;
+            const real h = dx * diff[0] + dy * diff[1] + dz * diff[2];
+            const real c = (diff[0] * diff[0] + diff[1] * diff[1] + diff[2] * diff[2]) - radius_sqr;
+            const real discriminant = h * h - a * c;
+            const real sqrtd = std::sqrt(discriminant);     // NaN lanes fail the tests below.
+
+            const real near_root = (h - sqrtd) / a;
+            const real root = (t_min < near_root && near_root < packet.t_max[i]) ? near_root : (h + sqrtd) / a;
+
+            const bool hit = packet.active[i] && discriminant >= 0 && t_min < root && root < packet.t_max[i];
+            packet.t_max[i] = hit ? root : packet.t_max[i];
+            packet.deferred[i] = packet.deferred[i] || hit;
+            packet.best_type[i] = hit ? PrimType::Sphere : packet.best_type[i];
+            packet.best[i] = hit ? s : packet.best[i];
+        }
+    }
+}
+
+// Lane-wise `hit_quad`, evaluated in the same order.
+void CompiledScene::hit_quads_packet(const Node &node, real t_min, Packet &packet) const {
+    const uint32_t end = node.offset + node.count;
+    for (uint32_t q = node.offset; q < end; q++) {
+        const QuadData &quad = quads_[q];
+        const real nx = quad.normal[0], ny = quad.normal[1], nz = quad.normal[2];
+
+        for (size_t i = 0; i < PACKET_SIZE; i++) {
+            const real ox = packet.origin[0][i], oy = packet.origin[1][i], oz = packet.origin[2][i];
+            const real dx = packet.dir[0][i], dy = packet.dir[1][i], dz = packet.dir[2][i];
+
+            const real denom = nx * dx + ny * dy + nz * dz;
+            const real t = (quad.D - (nx * ox + ny * oy + nz * oz)) / denom;
+
+            const real px = (ox + dx * t) - quad.origin[0];
+            const real py = (oy + dy * t) - quad.origin[1];
+            const real pz = (oz + dz * t) - quad.origin[2];
+
+            // dot(w, cross(p, v)) and dot(w, cross(u, p)).
+            const Vec3<real> &u = quad.u, &v = quad.v, &w = quad.w;
+            const real alpha = w[0] * (py * v[2] - pz * v[1]) + w[1] * (pz * v[0] - px * v[2]) + w[2] * (px * v[1] - py * v[0]);
+            const real beta = w[0] * (u[1] * pz - u[2] * py) + w[1] * (u[2] * px - u[0] * pz) + w[2] * (u[0] * py - u[1] * px);
+
+            const bool hit = packet.active[i] && !(std::fabs(denom) < 1e-8) && t_min <= t && t <= packet.t_max[i]
+                && alpha >= 0.0 && alpha <= 1.0 && beta >= 0.0 && beta <= 1.0;
+            packet.t_max[i] = hit ? t : packet.t_max[i];
+            packet.deferred[i] = packet.deferred[i] || hit;
+            packet.best_type[i] = hit ? PrimType::Quad : packet.best_type[i];
+            packet.best[i] = hit ? q : packet.best[i];
+        }
+    }
+}
+
+bool CompiledScene::hit_leaf(const Node &node, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const {
+    bool hit_anything = false;
+    const uint32_t end = node.offset + node.count;
+
+    RT_STAT(primitive_tests[static_cast<size_t>(node.type)] += node.count);
+    for (uint32_t i = node.offset; i < end; i++) {
+        bool hit = false;
+
+        switch (node.type) {
+            case PrimType::Sphere: hit = hit_sphere(spheres_[i], ray, ray_t, rec); break;
+            case PrimType::Quad: hit = hit_quad(quads_[i], ray, ray_t, rec); break;
+            case PrimType::Transform: hit = hit_transform(transforms_[i], ray, ray_t, rec); break;
+            case PrimType::Medium: hit = hit_medium(media_[i], ray, ray_t, rec); break;
+            case PrimType::Other: hit = others_[i]->hit(ray, ray_t, rec); break;
+        }
+
+        if (hit) {
+            hit_anything = true;
+            ray_t.max = rec.t;
+        }
+    }
+
+    return hit_anything;
+}
+
+bool CompiledScene::hit_sphere(const SphereData &sphere, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const {
+    const Point3<real> current_origin = sphere.center + ray.time() * sphere.velocity;
+    const auto diff = current_origin - ray.origin();
+    const auto a = ray.direction().length_sqr();
+    const auto h = dot(ray.direction(), diff);
+    const auto c = diff.length_sqr() - sphere.radius * sphere.radius;
+    const auto discriminant = h * h - a * c;
+
+    if (discriminant < 0) {
+        return false;
+    }
+
+    const auto sqrtd = std::sqrt(discriminant);
+
+    auto root = (h - sqrtd) / a;
+    if (!ray_t.surrounds(root)) {
+        root = (h + sqrtd) / a;
+        if (!ray_t.surrounds(root)) {
+            return false;
+        }
+    }
+
+    rec.t = root;
+    rec.p = ray.at(rec.t);
+    const Vec3<real> outward_normal = (rec.p - current_origin) / sphere.radius;
+    rec.set_face_normal(ray, outward_normal);
+    Sphere::get_uv(outward_normal, rec.u, rec.v);
+    rec.mat = materials_[sphere.mat];
+
+    return true;
+}
+
+bool CompiledScene::hit_quad(const QuadData &quad, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const {
+    const auto denom = dot(quad.normal, ray.direction());
+
+    if (std::fabs(denom) < 1e-8) {
+        return false;
+    }
+
+    const auto t = (quad.D - dot(quad.normal, Vec3<real>(ray.origin()))) / denom;
+    if (!ray_t.contains(t)) {
+        return false;
+    }
+
+    const auto intersection = ray.at(t);
+    const Vec3<real> p = intersection - quad.origin;
+    const auto alpha = dot(quad.w, cross(p, quad.v));
+    const auto beta = dot(quad.w, cross(quad.u, p));
+
+    if (!(alpha >= 0.0 && alpha <= 1.0 && beta >= 0.0 && beta <= 1.0)) {
+        return false;
+    }
+
+    rec.u = alpha;
+    rec.v = beta;
+    rec.t = t;
+    rec.p = intersection;
+    rec.mat = materials_[quad.mat];
+    rec.set_face_normal(ray, quad.normal);
+
+    return true;
+}
+
+bool CompiledScene::hit_transform(const TransformData &transform, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const {
+    const Transform &xf = transform.xf;
+    const Ray<real> local_ray(xf.point_to_object(ray.origin()), xf.vector_to_object(ray.direction()), ray.time());
+
+    if (!hit_tree(transform.root, local_ray, ray_t, rec)) {
+        return false;
+    }
+
+    rec.p = xf.point_to_world(rec.p);
+    rec.normal = normalize(xf.normal_to_world(rec.normal));
+
+    return true;
+}
+
+bool CompiledScene::hit_medium(const MediumData &medium, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const {
+    HitRecord rec_1, rec_2;
+
+    RT_STAT(medium_boundary_queries++);
+    if (!hit_tree(medium.boundary, ray, Interval::universe, rec_1)) return false;
+
+    RT_STAT(medium_boundary_queries++);
+    if (!hit_tree(medium.boundary, ray, Interval(rec_1.t + 1e-4, infinity), rec_2)) return false;
+
+    if (rec_1.t < ray_t.min) rec_1.t = ray_t.min;
+    if (rec_2.t > ray_t.max) rec_2.t = ray_t.max;
+
+    if (rec_1.t >= rec_2.t) return false;
+
+    if (rec_1.t < 0) rec_1.t = 0;
+
+    const auto ray_length = ray.direction().length();
+    const auto distance_inside_boundary = (rec_2.t - rec_1.t) * ray_length;
+    const auto hit_distance = medium.neg_inv_density * std::log(random_double());
+
+    if (hit_distance > distance_inside_boundary) return false;
+
+    rec.t = rec_1.t + hit_distance / ray_length;
+    rec.p = ray.at(rec.t);
+
+    rec.normal = Vec3<real>(1, 0, 0);     // Arbitrary
+    rec.front_face = true;                  // Arbitrary
+    rec.mat = materials_[medium.mat];
+
+    return true;
+}
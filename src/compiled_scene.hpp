@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "bbox.hpp"
+#include "hittable.hpp"
+#include "interval.hpp"
+#include "material.hpp"
+#include "transform.hpp"
+
+// Render-time representation of a scene. The `Hittable` hierarchy remains
+// the authoring API; `CompiledScene` flattens it into per-type contiguous
+// primitive arrays and a linear BVH whose leaves refer to a (type, index
+// range). Intersection dispatches on the leaf type instead of a virtual call
+// per node and per primitive.
+//
+// Boxes are lowered to their six quads. Translate, RotateY and Instance become
+// transform records pointing at the root of a child BVH in the same node
+// array; children shared between several parents are compiled once.
+// Hittables with no flat equivalent are kept as `Other` leaves and reached
+// through their virtual `hit`.
+class CompiledScene : public Hittable {
+public:
+    enum class PrimType : uint8_t { Sphere, Quad, Transform, Medium, Other };
+
+    struct SphereData {
+        Point3<real> center;
+        Vec3<real> velocity;
+        real radius;
+        uint32_t mat;
+    };
+
+    struct QuadData {
+        Point3<real> origin;
+        Vec3<real> u, v, w;
+        Vec3<real> normal;
+        real D;
+        uint32_t mat;
+    };
+
+    struct TransformData {
+        Transform xf;
+        uint32_t root;
+    };
+
+    struct MediumData {
+        uint32_t boundary;
+        real neg_inv_density;
+        uint32_t mat;
+    };
+
+    struct Node {
+        BBox3 bbox;
+        uint32_t offset;    // Interior: index of the right child. Leaf: first primitive.
+        uint16_t count;     // Number of primitives, 0 for interior nodes.
+        PrimType type;
+        uint8_t axis;       // Split axis of an interior node; the left child is the next node.
+    };
+
+    static constexpr size_t MAX_LEAF_SIZE = 4;
+    static constexpr size_t PACKET_SIZE = 8;
+    // Entries of the traversal stack; a tree with `n` interior levels needs
+    // n + 1.
+    static constexpr size_t STACK_SIZE = 64;
+
+    CompiledScene(const std::vector<std::shared_ptr<Hittable>> &objs);
+
+    // The spans point into this object's own arrays.
+    CompiledScene(const CompiledScene &) = delete;
+    CompiledScene& operator=(const CompiledScene &) = delete;
+
+    bool hit(const Ray<real> &ray, Interval ray_t, HitRecord &rec) const override { return hit_tree(root_, ray, ray_t, rec); }
+
+    BBox3 bounding_box() const override { return nodes_[root_].bbox; }
+
+    // Closest hits of up to PACKET_SIZE coherent rays. The packet walks the
+    // BVH together with one shared stack, testing each node's box and each
+    // sphere or quad leaf against all rays at once. Other leaves are
+    // intersected per ray. `hits[i]` tells whether `recs[i]` was filled.
+    void hit_packet(const Ray<real> *rays, size_t count, Interval ray_t, HitRecord *recs, bool *hits) const;
+
+    std::span<const Node> nodes() const { return nodes_; }
+    std::span<const SphereData> spheres() const { return spheres_; }
+    std::span<const QuadData> quads() const { return quads_; }
+
+private:
+    struct PrimRef {
+        PrimType type;
+        uint32_t index;     // Index into the staging arrays of the current build.
+        BBox3 bbox;
+    };
+
+    // Rays of a packet in structure-of-arrays form, lane-wise loops over these
+    // compile to SIMD code.
+    struct Packet {
+        real origin[3][PACKET_SIZE];
+        real dir[3][PACKET_SIZE];
+        real inv_dir[3][PACKET_SIZE];
+        real time[PACKET_SIZE];
+        real t_max[PACKET_SIZE];
+        bool active[PACKET_SIZE];
+
+        // Closest sphere or quad found so far; its record is filled in once
+        // traversal ends.
+        bool deferred[PACKET_SIZE];
+        PrimType best_type[PACKET_SIZE];
+        uint32_t best[PACKET_SIZE];
+    };
+
+    struct Staging {
+        std::vector<PrimRef> refs;
+        std::vector<SphereData> spheres;
+        std::vector<QuadData> quads;
+        std::vector<TransformData> transforms;
+        std::vector<MediumData> media;
+        std::vector<std::shared_ptr<Hittable>> others;
+    };
+
+    // Arrays filled while compiling. A scene loaded from a file leaves them
+    // empty and points the spans below into the mapped file instead, unless
+    // it was loaded as a copy.
+    struct Arrays {
+        std::vector<Node> nodes;
+        std::vector<SphereData> spheres;
+        std::vector<QuadData> quads;
+        std::vector<TransformData> transforms;
+        std::vector<MediumData> media;
+    };
+
+    Arrays arrays_;
+    std::shared_ptr<const void> mapping_;
+
+    std::span<const Node> nodes_;
+    std::span<const SphereData> spheres_;
+    std::span<const QuadData> quads_;
+    std::span<const TransformData> transforms_;
+    std::span<const MediumData> media_;
+    std::vector<std::shared_ptr<Hittable>> others_;
+    std::vector<std::shared_ptr<Material>> materials_;
+    uint32_t root_;
+
+    // Build-time lookup tables.
+    std::unordered_map<const Hittable*, uint32_t> subtree_roots_;
+    std::unordered_map<const Material*, uint32_t> material_indices_;
+
+    CompiledScene() {}
+
+    uint32_t compile(const std::vector<std::shared_ptr<Hittable>> &objs);
+    uint32_t compile_subtree(const std::shared_ptr<Hittable> &obj);
+    void gather(const std::shared_ptr<Hittable> &obj, Staging &staging);
+    void add_quad(const Point3<real> &origin, const Vec3<real> &u, const Vec3<real> &v, const std::shared_ptr<Material> &mat, const BBox3 &bbox, Staging &staging);
+    void add_transform(const std::shared_ptr<Hittable> &child, const Transform &xf, const BBox3 &bbox, Staging &staging);
+    uint32_t build(Staging &staging, size_t start, size_t end);
+    void emit_leaf(Staging &staging, size_t start, size_t end, Node &node);
+    uint32_t material_index(const std::shared_ptr<Material> &mat);
+
+    bool hit_box_packet(const BBox3 &bbox, real t_min, Packet &packet) const;
+    void hit_spheres_packet(const Node &node, real t_min, Packet &packet) const;
+    void hit_quads_packet(const Node &node, real t_min, Packet &packet) const;
+    bool hit_tree(uint32_t root, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const;
+    bool hit_leaf(const Node &node, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const;
+    bool hit_sphere(const SphereData &sphere, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const;
+    bool hit_quad(const QuadData &quad, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const;
+    bool hit_transform(const TransformData &transform, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const;
+    bool hit_medium(const MediumData &medium, const Ray<real> &ray, Interval ray_t, HitRecord &rec) const;
+
+    friend class SceneFile;
+};
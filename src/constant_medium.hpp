@@ -1,23 +1,28 @@
 #pragma once
 
+#include "arena.hpp"
 #include "bbox.hpp"
 #include "hittable.hpp"
 #include "interval.hpp"
 #include "material.hpp"
+#include "stats.hpp"
 #include "texture.hpp"
 #include "util.hpp"
 
 class ConstantMedium : public Hittable {
 public:
-    ConstantMedium(std::shared_ptr<Hittable> boundary, double density, std::shared_ptr<Texture> texture) : boundary_(boundary), neg_inv_density_(-1 / density), phase_function_(std::make_shared<Isotropic>(texture)) {}
-    ConstantMedium(std::shared_ptr<Hittable> boundary, double density, const Color & color) : boundary_(boundary), neg_inv_density_(-1 / density), phase_function_(std::make_shared<Isotropic>(color)) {}
-    ConstantMedium(std::shared_ptr<Hittable> boundary, double density, std::shared_ptr<Material> mat_) : boundary_(boundary), neg_inv_density_(-1 / density), phase_function_(mat_) {}
+    ConstantMedium(std::shared_ptr<Hittable> boundary, real density, std::shared_ptr<Texture> texture) : boundary_(boundary), neg_inv_density_(-1 / density), phase_function_(make_arena_shared<Isotropic>(texture)) {}
+    ConstantMedium(std::shared_ptr<Hittable> boundary, real density, const Color & color) : boundary_(boundary), neg_inv_density_(-1 / density), phase_function_(make_arena_shared<Isotropic>(color)) {}
+    ConstantMedium(std::shared_ptr<Hittable> boundary, real density, std::shared_ptr<Material> mat_) : boundary_(boundary), neg_inv_density_(-1 / density), phase_function_(mat_) {}
 
-    bool hit(const Ray<double> &ray, Interval ray_t, HitRecord &rec) const override {
+    bool hit(const Ray<real> &ray, Interval ray_t, HitRecord &rec) const override {
         HitRecord rec_1, rec_2;
 
+        RT_STAT(primitive_tests[TraversalStats::MEDIUM]++);
+        RT_STAT(medium_boundary_queries++);
         if (!boundary_->hit(ray, Interval::universe, rec_1)) return false;
 
+        RT_STAT(medium_boundary_queries++);
         if (!boundary_->hit(ray, Interval(rec_1.t + 1e-4, infinity), rec_2)) return false;
 
         if (rec_1.t < ray_t.min) rec_1.t = ray_t.min;
@@ -36,7 +41,7 @@ public:
         rec.t = rec_1.t + hit_distance / ray_length;
         rec.p = ray.at(rec.t);
 
-        rec.normal = Vec3<double>(1, 0, 0);     // Arbitrary
+        rec.normal = Vec3<real>(1, 0, 0);     // Arbitrary
         rec.front_face = true;                  // Arbitrary
         rec.mat = phase_function_;
 
@@ -49,8 +54,9 @@ public:
 
 private:
     std::shared_ptr<Hittable> boundary_;
-    double neg_inv_density_;
+    real neg_inv_density_;
     std::shared_ptr<Material> phase_function_;
 
     friend struct YAML::convert<std::shared_ptr<ConstantMedium>>;
+    friend class CompiledScene;
 };
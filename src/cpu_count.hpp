@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// How many threads this process can run in parallel: the least of the
+// hardware threads, the CPUs in its affinity mask and its cgroup CPU quota
+// (rounded up). In a container the first reports the host's cores, which
+// oversubscribes a pod limited to a few CPUs.
+struct CpuCount {
+    uint32_t count;
+    std::string source;     // Which limit decided `count`, for logging.
+
+    // Detected once per process.
+    static const CpuCount& get() {
+        static const CpuCount cpus = detect();
+        return cpus;
+    }
+
+    // A cgroup directory with a CPU controller, as found by `cgroup_dirs`.
+    struct CgroupDir {
+        int version;    // 1 or 2.
+        std::filesystem::path path;
+        std::filesystem::path mount_point;
+    };
+
+    // The directories of the CPU controllers of the cgroups in
+    // `proc_self_cgroup` (the contents of /proc/self/cgroup), resolved through
+    // the mounts in `mountinfo` (/proc/self/mountinfo).
+    static std::vector<CgroupDir> cgroup_dirs(const std::string &proc_self_cgroup, const std::string &mountinfo) {
+        struct Mount {
+            int version;
+            std::string root, mount_point;
+        };
+
+        std::vector<Mount> mounts;
+        std::istringstream mount_lines(mountinfo);
+        for (std::string line; std::getline(mount_lines, line);) {
+            // id parent major:minor root mount-point options [optional...] - type source super-options
+            std::istringstream fields(line);
+            std::string id, parent, device, root, mount_point, field;
+            fields >> id >> parent >> device >> root >> mount_point;
+            while (fields >> field && field != "-") {}
+            std::string type, source, super_options;
+            fields >> type >> source >> super_options;
+
+            if (type == "cgroup2") {
+                mounts.push_back({ 2, root, mount_point });
+            } else if (type == "cgroup" && has_controller("," + super_options + ",", "cpu")) {
+                mounts.push_back({ 1, root, mount_point });
+            }
+        }
+
+        std::vector<CgroupDir> dirs;
+        std::istringstream cgroup_lines(proc_self_cgroup);
+        for (std::string line; std::getline(cgroup_lines, line);) {
+            // hierarchy-id:controllers:path, with id 0 and no controllers for v2.
+            const auto first = line.find(':'), second = line.find(':', first + 1);
+            if (first == std::string::npos || second == std::string::npos) continue;
+
+            const std::string controllers = line.substr(first + 1, second - first - 1);
+            const std::string path = line.substr(second + 1);
+            const int version = controllers.empty() ? 2 : 1;
+            if (version == 1 && !has_controller("," + controllers + ",", "cpu")) continue;
+
+            for (const auto &mount : mounts) {
+                if (mount.version != version) continue;
+
+                // Inside a cgroup namespace the path may lie outside the
+                // mount's root; the mount point is then the cgroup itself.
+                std::string relative = path;
+                if (mount.root != "/") {
+                    relative = path.starts_with(mount.root) ? path.substr(mount.root.size()) : "";
+                }
+                std::filesystem::path dir = mount.mount_point;
+                if (const auto rest = std::filesystem::path(relative).relative_path(); !rest.empty()) {
+                    dir /= rest;
+                }
+                dirs.push_back({ version, dir, mount.mount_point });
+            }
+        }
+
+        return dirs;
+    }
+
+    // CPUs allowed by a quota of `quota` microseconds every `period`, rounded
+    // up; none when unlimited.
+    static std::optional<uint32_t> quota_cpus(int64_t quota, int64_t period) {
+        if (quota <= 0 || period <= 0) return std::nullopt;
+        return static_cast<uint32_t>(std::max<int64_t>((quota + period - 1) / period, 1));
+    }
+
+private:
+    static bool has_controller(const std::string &comma_list, const std::string &controller) {
+        return comma_list.contains("," + controller + ",");
+    }
+
+    static std::string read_file(const std::filesystem::path &path) {
+        std::ifstream file(path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    // The smallest quota of `dir` and its ancestors up to the mount point, as
+    // quotas nest.
+    static std::optional<uint32_t> cgroup_quota(const CgroupDir &dir) {
+        std::optional<uint32_t> cpus;
+        for (auto path = dir.path;; path = path.parent_path()) {
+            int64_t quota = -1, period = 0;
+            if (dir.version == 2) {
+                // cpu.max is "max 100000" or "<quota> <period>".
+                std::istringstream cpu_max(read_file(path / "cpu.max"));
+                std::string q;
+                if (cpu_max >> q >> period && q != "max") quota = std::stoll(q);
+            } else {
+                std::istringstream(read_file(path / "cpu.cfs_quota_us")) >> quota;
+                std::istringstream(read_file(path / "cpu.cfs_period_us")) >> period;
+            }
+
+            if (auto limit = quota_cpus(quota, period)) {
+                cpus = std::min(cpus.value_or(*limit), *limit);
+            }
+            if (path == dir.mount_point || path == path.parent_path()) break;
+        }
+        return cpus;
+    }
+
+    static CpuCount detect() {
+        CpuCount cpus{ std::max(std::thread::hardware_concurrency(), 1u), "hardware concurrency" };
+
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            const uint32_t allowed = CPU_COUNT(&set);
+            if (allowed > 0 && allowed < cpus.count) {
+                cpus = { allowed, "sched_getaffinity" };
+            }
+        }
+
+        try {
+            for (const auto &dir : cgroup_dirs(read_file("/proc/self/cgroup"), read_file("/proc/self/mountinfo"))) {
+                const auto quota = cgroup_quota(dir);
+                if (quota && *quota < cpus.count) {
+                    cpus = { *quota, std::format("cgroup v{} CPU quota of {}", dir.version, dir.path.string()) };
+                }
+            }
+        } catch (const std::exception &) {
+            // Unreadable or malformed cgroup files leave the other limits.
+        }
+#endif
+
+        return cpus;
+    }
+};
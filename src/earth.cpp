@@ -4,7 +4,7 @@
 int main() {
     const auto earth_texture = std::make_shared<ImageTexture>("earthmap.jpg");
     const auto earth_surface = std::make_shared<Lambertian>(earth_texture);
-    const auto globe = std::make_shared<Sphere>(Point3<double>(0, 0, 0), 2, earth_surface);
+    const auto globe = std::make_shared<Sphere>(Point3<real>(0, 0, 0), 2, earth_surface);
 
     Scene scene;
     scene.add_texture(earth_texture);
@@ -0,0 +1,45 @@
+#include "heatmap.hpp"
+#include <algorithm>
+
+// Maps `t` in [0, 1] onto black-red-yellow-white. The stops are display
+// values, so they are squared to undo the gamma applied when writing.
+static Color heat(real t) {
+    const real r = std::clamp<real>(3 * t, 0, 1);
+    const real g = std::clamp<real>(3 * t - 1, 0, 1);
+    const real b = std::clamp<real>(3 * t - 2, 0, 1);
+
+    return Color(r * r, g * g, b * b);
+}
+
+static double cost_per_pixel(const TileCost &tile) {
+    return tile.seconds / std::max(tile.width * tile.height, 1);
+}
+
+Image tile_heatmap(const std::vector<TileCost> &tiles, int32_t width, int32_t height) {
+    Image img(width, height);
+
+    double max_cost = 0;
+    for (const auto &tile : tiles) {
+        max_cost = std::max(max_cost, cost_per_pixel(tile));
+    }
+
+    for (const auto &tile : tiles) {
+        const Color color = heat(max_cost > 0 ? cost_per_pixel(tile) / max_cost : 0);
+        for (int32_t i = tile.x; i < std::min(tile.x + tile.height, height); i++) {
+            for (int32_t j = tile.y; j < std::min(tile.y + tile.width, width); j++) {
+                img.pixels_[i][j] = color;
+            }
+        }
+    }
+
+    return img;
+}
+
+std::ostream& write_tile_csv(std::ostream &out, const std::vector<TileCost> &tiles) {
+    out << "row,column,width,height,seconds,rays,rays_per_second\n";
+    for (const auto &tile : tiles) {
+        out << std::format("{},{},{},{},{:.6f},{},{:.0f}\n", tile.x, tile.y, tile.width, tile.height, tile.seconds, tile.rays, tile.seconds > 0 ? tile.rays / tile.seconds : 0);
+    }
+
+    return out;
+}
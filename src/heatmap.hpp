@@ -0,0 +1,14 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "image.hpp"
+#include "render.hpp"
+
+// Paints each tile by its render time per pixel, from black for the cheapest
+// through red and yellow to white for the most expensive.
+Image tile_heatmap(const std::vector<TileCost> &tiles, int32_t width, int32_t height);
+
+// Writes one CSV row per tile: position, size, seconds, rays and rays per second.
+std::ostream& write_tile_csv(std::ostream &out, const std::vector<TileCost> &tiles);
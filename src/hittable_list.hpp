@@ -20,7 +20,7 @@ public:
         bbox = BBox3(bbox, obj->bounding_box());
     }
 
-    bool hit(const Ray<double>& ray, Interval ray_t, HitRecord& rec) const override {
+    bool hit(const Ray<real>& ray, Interval ray_t, HitRecord& rec) const override {
         HitRecord temp_rec;
         bool hit_anything = false;
         auto closest_so_far = ray_t.max;
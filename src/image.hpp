@@ -1,8 +1,11 @@
 #pragma once
 
+#include <bit>
 #include <cassert>
 #include <cstdint>
 #include <iostream>
+#include <string>
+#include <vector>
 #include "color.hpp"
 
 class AspectRatio {
@@ -27,8 +30,15 @@ class ImageChunk {
 public:
     int32_t x, y, width, height;
     std::vector<std::vector<Color>> &pixels;
+    int32_t pixels_x = 0, pixels_y = 0;     // Image row and column of pixels[0][0].
 
     ImageChunk(int32_t x, int32_t y, int32_t w, int32_t h, std::vector<std::vector<Color>> &pixels) : x(x), y(y), width(w), height(h), pixels(pixels) {}
+
+    // Renders into a buffer holding only part of the image.
+    ImageChunk(int32_t x, int32_t y, int32_t w, int32_t h, std::vector<std::vector<Color>> &pixels, int32_t pixels_x, int32_t pixels_y) : x(x), y(y), width(w), height(h), pixels(pixels), pixels_x(pixels_x), pixels_y(pixels_y) {}
+
+    // The pixel at image row `i`, column `j`.
+    Color& at(int32_t i, int32_t j) const { return pixels[i - pixels_x][j - pixels_y]; }
 };
 
 class Image {
@@ -56,9 +66,86 @@ public:
 
         return out;
     }
+
+    // Reads a P3 image as written by `write`. Pixels keep their gamma-encoded
+    // values scaled to [0, 1).
+    std::istream& read(std::istream& in) {
+        std::string magic;
+        int32_t max_value;
+        in >> magic >> width_ >> height_ >> max_value;
+        if (magic != "P3" || width_ <= 0 || height_ <= 0) {
+            in.setstate(std::ios::failbit);
+            return in;
+        }
+
+        ar_ = AspectRatio(width_, height_);
+        pixels_.assign(height_, std::vector<Color>(width_));
+        for (int32_t i = 0; i < height_; i++) {
+            for (int32_t j = 0; j < width_; j++) {
+                int32_t r, g, b;
+                in >> r >> g >> b;
+                pixels_[i][j] = Color(r, g, b);
+            }
+        }
+
+        return in;
+    }
+
+    // Writes the linear pixel values, without gamma or clamping, as a color
+    // PFM (little-endian floats, bottom row first).
+    std::ostream& write_pfm(std::ostream& out) const {
+        out << "PF\n" << width_ << ' ' << height_ << "\n-1.0\n";
+
+        std::vector<float> row(3 * width_);
+        for (int32_t i = height_ - 1; i >= 0; i--) {
+            for (int32_t j = 0; j < width_; j++) {
+                for (int c = 0; c < 3; c++) {
+                    row[3 * j + c] = to_little_endian(static_cast<float>(pixels_[i][j].elem[c]));
+                }
+            }
+            out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+        }
+
+        return out;
+    }
+
+    // Reads a color PFM. Pixels keep their linear values.
+    std::istream& read_pfm(std::istream& in) {
+        std::string magic;
+        double scale;
+        in >> magic >> width_ >> height_ >> scale;
+        in.get();
+        if (magic != "PF" || width_ <= 0 || height_ <= 0) {
+            in.setstate(std::ios::failbit);
+            return in;
+        }
+
+        // A negative scale marks little-endian data.
+        const bool swap = (scale < 0) != (std::endian::native == std::endian::little);
+        ar_ = AspectRatio(width_, height_);
+        pixels_.assign(height_, std::vector<Color>(width_));
+        std::vector<float> row(3 * width_);
+        for (int32_t i = height_ - 1; i >= 0 && in.read(reinterpret_cast<char*>(row.data()), row.size() * sizeof(float)); i--) {
+            for (int32_t j = 0; j < width_; j++) {
+                const auto value = [&](int c) { return swap ? byteswap(row[3 * j + c]) : row[3 * j + c]; };
+                pixels_[i][j] = Color(value(0), value(1), value(2));
+            }
+        }
+
+        return in;
+    }
+
+private:
+    static float byteswap(float f) { return std::bit_cast<float>(std::byteswap(std::bit_cast<uint32_t>(f))); }
+
+    static float to_little_endian(float f) { return std::endian::native == std::endian::little ? f : byteswap(f); }
 };
 
 
 inline std::ostream& operator<<(std::ostream& out, const Image &img) {
     return img.write(out);
 }
+
+inline std::istream& operator>>(std::istream& in, Image &img) {
+    return img.read(in);
+}
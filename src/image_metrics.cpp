@@ -0,0 +1,197 @@
+#include "image_metrics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// One channel of an image, row by row.
+struct Plane {
+    int32_t width, height;
+    std::vector<double> values;
+
+    Plane(int32_t width, int32_t height) : width(width), height(height), values(static_cast<size_t>(width) * height) {}
+
+    double& at(int32_t i, int32_t j) { return values[static_cast<size_t>(i) * width + j]; }
+    double at(int32_t i, int32_t j) const { return values[static_cast<size_t>(std::clamp(i, 0, height - 1)) * width + std::clamp(j, 0, width - 1)]; }
+};
+
+// The opponent space FLIP filters in: lightness and two chroma axes, linear in
+// CIE XYZ relative to the D65 white point.
+struct YCxCz {
+    Plane y, cx, cz;
+
+    YCxCz(int32_t width, int32_t height) : y(width, height), cx(width, height), cz(width, height) {}
+};
+
+struct XYZ {
+    double x, y, z;     // Relative to the D65 white point.
+};
+
+static XYZ srgb_to_xyz(double r, double g, double b) {
+    return {
+        (0.4124564 * r + 0.3575761 * g + 0.1804375 * b) / 0.95047,
+        0.2126729 * r + 0.7151522 * g + 0.0721750 * b,
+        (0.0193339 * r + 0.1191920 * g + 0.9503041 * b) / 1.08883,
+    };
+}
+
+static double lab_f(double t) {
+    constexpr double delta = 6.0 / 29.0;
+    return t > delta * delta * delta ? std::cbrt(t) : t / (3 * delta * delta) + 4.0 / 29.0;
+}
+
+// HyAB distance between two colors: absolute lightness difference plus
+// Euclidean chroma difference in L*a*b*, which suits large differences
+// better than Delta E.
+static double hyab(const XYZ &p, const XYZ &q) {
+    const double fpy = lab_f(p.y), fqy = lab_f(q.y);
+    const double dl = 116 * (fpy - fqy);
+    const double da = 500 * ((lab_f(p.x) - fpy) - (lab_f(q.x) - fqy));
+    const double db = 200 * ((fpy - lab_f(p.z)) - (fqy - lab_f(q.z)));
+
+    return std::fabs(dl) + std::sqrt(da * da + db * db);
+}
+
+static YCxCz to_ycxcz(const Image &display) {
+    YCxCz out(display.width_, display.height_);
+    for (int32_t i = 0; i < display.height_; i++) {
+        for (int32_t j = 0; j < display.width_; j++) {
+            const Color &c = display.pixels_[i][j];
+            const XYZ p = srgb_to_xyz(c.r() * c.r(), c.g() * c.g(), c.b() * c.b());
+            out.y.at(i, j) = 116 * p.y - 16;
+            out.cx.at(i, j) = 500 * (p.x - p.y);
+            out.cz.at(i, j) = 200 * (p.y - p.z);
+        }
+    }
+
+    return out;
+}
+
+static XYZ to_xyz(const YCxCz &c, int32_t i, int32_t j) {
+    const double y = (c.y.at(i, j) + 16) / 116;
+    return { std::max(c.cx.at(i, j) / 500 + y, 0.0), std::max(y, 0.0), std::max(y - c.cz.at(i, j) / 200, 0.0) };
+}
+
+// Separable Gaussian blur with clamped edges. Leaves `plane` alone when the
+// kernel is narrower than a pixel.
+static void blur(Plane &plane, double sigma) {
+    if (sigma < 0.5) return;
+
+    const int32_t radius = static_cast<int32_t>(std::ceil(3 * sigma));
+    std::vector<double> weights(2 * radius + 1);
+    double total = 0;
+    for (int32_t k = -radius; k <= radius; k++) {
+        weights[k + radius] = std::exp(-k * k / (2 * sigma * sigma));
+        total += weights[k + radius];
+    }
+    for (auto &w : weights) {
+        w /= total;
+    }
+
+    Plane tmp(plane.width, plane.height);
+    for (int32_t i = 0; i < plane.height; i++) {
+        for (int32_t j = 0; j < plane.width; j++) {
+            double sum = 0;
+            for (int32_t k = -radius; k <= radius; k++) {
+                sum += weights[k + radius] * std::as_const(plane).at(i, j + k);
+            }
+            tmp.at(i, j) = sum;
+        }
+    }
+    for (int32_t i = 0; i < plane.height; i++) {
+        for (int32_t j = 0; j < plane.width; j++) {
+            double sum = 0;
+            for (int32_t k = -radius; k <= radius; k++) {
+                sum += weights[k + radius] * std::as_const(tmp).at(i + k, j);
+            }
+            plane.at(i, j) = sum;
+        }
+    }
+}
+
+// Sobel gradient magnitude of the lightness, scaled to [0, 1].
+static double edge(const Plane &y, int32_t i, int32_t j) {
+    const auto l = [&](int32_t di, int32_t dj) { return std::clamp(y.at(i + di, j + dj) / 100, 0.0, 1.0); };
+    const double gx = (l(-1, 1) + 2 * l(0, 1) + l(1, 1) - l(-1, -1) - 2 * l(0, -1) - l(1, -1)) / 4;
+    const double gy = (l(1, -1) + 2 * l(1, 0) + l(1, 1) - l(-1, -1) - 2 * l(-1, 0) - l(-1, 1)) / 4;
+
+    return std::sqrt(gx * gx + gy * gy);
+}
+
+Image flip_error(const Image &reference, const Image &image, double pixels_per_degree) {
+    // Spreads of the achromatic and chromatic contrast sensitivity, in
+    // degrees, and the exponents FLIP uses.
+    constexpr double ACHROMATIC_SPREAD = 0.0047;
+    constexpr double CHROMATIC_SPREAD = 0.053;
+    constexpr double COLOR_EXPONENT = 0.7;
+    constexpr double FEATURE_EXPONENT = 0.5;
+
+    // Features are found in the unfiltered lightness.
+    const YCxCz unfiltered[2] = { to_ycxcz(reference), to_ycxcz(image) };
+    YCxCz planes[2] = { unfiltered[0], unfiltered[1] };
+    for (auto &p : planes) {
+        blur(p.y, ACHROMATIC_SPREAD * pixels_per_degree);
+        blur(p.cx, CHROMATIC_SPREAD * pixels_per_degree);
+        blur(p.cz, CHROMATIC_SPREAD * pixels_per_degree);
+    }
+
+    static const double max_hyab = hyab(srgb_to_xyz(0, 1, 0), srgb_to_xyz(0, 0, 1));
+
+    Image error(reference.width_, reference.height_);
+    for (int32_t i = 0; i < error.height_; i++) {
+        for (int32_t j = 0; j < error.width_; j++) {
+            const double color = std::min(std::pow(hyab(to_xyz(planes[0], i, j), to_xyz(planes[1], i, j)) / max_hyab, COLOR_EXPONENT), 1.0);
+            const double feature = std::min(std::pow(std::fabs(edge(unfiltered[0].y, i, j) - edge(unfiltered[1].y, i, j)) / std::sqrt(2.0), FEATURE_EXPONENT), 1.0);
+            const double e = std::pow(color, 1 - feature);
+            error.pixels_[i][j] = Color(e, e, e);
+        }
+    }
+
+    return error;
+}
+
+ImageError compare_images(const Image &reference, const Image &image, double pixels_per_degree, PixelSpace space) {
+    ImageError err;
+    double sum = 0, sum_sqr = 0, sum_rel_sqr = 0;
+    for (int32_t i = 0; i < image.height_; i++) {
+        for (int32_t j = 0; j < image.width_; j++) {
+            for (int c = 0; c < 3; c++) {
+                const double ref = reference.pixels_[i][j].elem[c];
+                const double diff = image.pixels_[i][j].elem[c] - ref;
+                sum += diff;
+                sum_sqr += diff * diff;
+                // The epsilon keeps black reference pixels finite.
+                sum_rel_sqr += diff * diff / (ref * ref + 1e-2);
+                err.max = std::max(err.max, std::fabs(diff));
+            }
+        }
+    }
+
+    const double n = 3.0 * image.width_ * image.height_;
+    err.mse = sum_sqr / n;
+    err.rmse = std::sqrt(err.mse);
+    err.relmse = sum_rel_sqr / n;
+    err.psnr = err.mse > 0 ? 10 * std::log10(1 / err.mse) : infinity;
+    err.bias = sum / n;
+
+    const Image flip = space == PixelSpace::Linear ? flip_error(to_display(reference), to_display(image), pixels_per_degree) : flip_error(reference, image, pixels_per_degree);
+    for (const auto &row : flip.pixels_) {
+        for (const auto &pixel : row) {
+            err.flip += pixel.r() / (n / 3);
+        }
+    }
+
+    return err;
+}
+
+Image to_display(const Image &linear) {
+    Image display(linear.width_, linear.height_);
+    for (int32_t i = 0; i < linear.height_; i++) {
+        for (int32_t j = 0; j < linear.width_; j++) {
+            const Color &c = linear.pixels_[i][j];
+            display.pixels_[i][j] = Color(intensity.clamp(linear_to_gamma(c.r())), intensity.clamp(linear_to_gamma(c.g())), intensity.clamp(linear_to_gamma(c.b())));
+        }
+    }
+
+    return display;
+}
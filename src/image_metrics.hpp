@@ -0,0 +1,37 @@
+#pragma once
+
+#include "image.hpp"
+
+// A 3840 pixel wide, 0.7 m monitor seen from 0.7 m, as FLIP assumes.
+constexpr double DEFAULT_PIXELS_PER_DEGREE = 67.0;
+
+// What the pixels passed to `compare_images` hold: display values
+// (gamma-encoded, in [0, 1], as read from a PPM) or linear radiance (as
+// rendered, or read from a PFM), which may exceed 1.
+enum class PixelSpace { Display, Linear };
+
+// Differences between an image and a reference of the same size. All but
+// `flip` are measured on the pixels as given, so on linear pixels an error
+// above 1 (e.g. around a light) counts in full; `flip` always compares
+// display values.
+struct ImageError {
+    double mse = 0;
+    double rmse = 0;
+    double relmse = 0;  // Squared error over the squared reference, so dark regions count as much as bright ones.
+    double psnr = 0;    // In dB against a peak of 1, infinite for identical images.
+    double max = 0;     // Largest error of any channel.
+    double bias = 0;    // Mean signed error.
+    double flip = 0;    // Mean of `flip_error`, in [0, 1].
+};
+
+ImageError compare_images(const Image &reference, const Image &image, double pixels_per_degree = DEFAULT_PIXELS_PER_DEGREE, PixelSpace space = PixelSpace::Display);
+
+// Perceptual difference in the spirit of NVIDIA's FLIP: a color difference
+// (HyAB in L*a*b*) of the images blurred as the eye would at
+// `pixels_per_degree`, amplified where edges and points differ. Per pixel,
+// 0 is indistinguishable and 1 is the difference between green and blue. A
+// simplified approximation, not the reference implementation.
+Image flip_error(const Image &reference, const Image &image, double pixels_per_degree = DEFAULT_PIXELS_PER_DEGREE);
+
+// Converts linear pixels (as rendered, or read from a PFM) to display values.
+Image to_display(const Image &linear);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+
+#include "bbox.hpp"
+#include "hittable.hpp"
+#include "interval.hpp"
+#include "transform.hpp"
+
+// A transformed reference to shared geometry. The referenced object is
+// usually a bottom-level BVH owned by the scene, so any number of instances
+// cost one record each rather than a copy of the geometry.
+class Instance : public Hittable {
+public:
+    Instance(std::shared_ptr<Hittable> object, const Transform &xf) : object_(object), xf_(xf), bbox_(xf_.bbox_to_world(object_->bounding_box())) {}
+
+    bool hit(const Ray<real> &ray, Interval ray_t, HitRecord &rec) const override {
+        // The direction is not renormalized, so `t` is the same in both spaces.
+        const Ray<real> local_ray(xf_.point_to_object(ray.origin()), xf_.vector_to_object(ray.direction()), ray.time());
+
+        if (!object_->hit(local_ray, ray_t, rec)) {
+            return false;
+        }
+
+        rec.p = xf_.point_to_world(rec.p);
+        rec.normal = normalize(xf_.normal_to_world(rec.normal));
+
+        return true;
+    }
+
+    BBox3 bounding_box() const override { return bbox_; }
+
+    const std::shared_ptr<Hittable>& object() const { return object_; }
+    const Transform& transform() const { return xf_; }
+
+    inline static const std::string NAME = "instance";
+
+private:
+    std::shared_ptr<Hittable> object_;
+    Transform xf_;
+    BBox3 bbox_;
+};
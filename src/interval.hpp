@@ -4,39 +4,39 @@
 
 class Interval {
 public:
-    double min, max;
+    real min, max;
 
     Interval() : min(+infinity), max(-infinity) {} // Default is empty
 
-    Interval(double min, double max) : min(min), max(max) {}
+    Interval(real min, real max) : min(min), max(max) {}
 
     Interval(const Interval &a, const Interval &b) : min(std::min(a.min, b.min)), max(std::max(a.max, b.max)) {}
 
-    double span() const { return max - min; }
+    real span() const { return max - min; }
 
-    bool contains(double x) const { return min <= x && x <= max; }
+    bool contains(real x) const { return min <= x && x <= max; }
 
-    bool surrounds(double x) const { return min < x && x < max; }
+    bool surrounds(real x) const { return min < x && x < max; }
 
-    double clamp(double x) const {
+    real clamp(real x) const {
         if (x <= min) return min;
         else if (x >= max) return max;
 
         return x; 
     }
 
-    Interval expand(double delta) {
-        const double padding = delta / 2;
+    Interval expand(real delta) {
+        const real padding = delta / 2;
         return Interval(min - padding, max + padding);
     }
 
     static const Interval empty, universe;
 };
 
-inline Interval operator+(const Interval &interval, const double delta) {
+inline Interval operator+(const Interval &interval, const real delta) {
     return Interval(interval.min + delta, interval.max + delta);
 }
 
-inline Interval operator+(const double delta, const Interval &interval) {
+inline Interval operator+(const real delta, const Interval &interval) {
     return interval + delta;
 }
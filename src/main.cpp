@@ -1,20 +1,60 @@
+#include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
 #include <optional>
 #include <unistd.h>
 #include <cassert>
+#include <filesystem>
 #include <fstream>
 #include "camera.hpp"
+#include "cpu_count.hpp"
+#include "heatmap.hpp"
 #include "hittable.hpp"
 #include "hittable_list.hpp"
+#include "numa.hpp"
 #include "render.hpp"
+#include "ray_capture.hpp"
+#include "render_server.hpp"
 #include "image.hpp"
 #include "scene.hpp"
+#include "scene_cache.hpp"
+#include "scene_file.hpp"
+#include "trace.hpp"
 #include "serialization.hpp"
 #include "argparse/argparse.hpp"
 #include "vec3.hpp"
 
+// Renders progressively, writing the running average to `dir` after passes 1,
+// 2, 4, ... and the last one, each listed in `dir`/snapshots.csv with its time,
+// for `compare` to chart error against time. Throws `std::runtime_error` if
+// a file can't be written.
+static RenderStats render_snapshots(Image &img, const Camera &cam, const Hittable &scene, const RenderSettings &rs, uint32_t passes, const std::filesystem::path &dir) {
+    std::filesystem::create_directories(dir);
+    std::ofstream csv(dir / "snapshots.csv");
+    csv << "pass,samples_per_pixel,seconds,file\n";
+
+    const uint32_t last = std::clamp<uint32_t>(passes, 1, rs.samples_per_pixel_);
+    uint32_t pass = 0;
+    const RenderStats stats = render_progressive(img, cam, scene, rs, passes, [&](const Image &average, uint32_t samples_per_pixel, double seconds) {
+        pass++;
+        if (!std::has_single_bit(pass) && pass != last) return;
+
+        const std::string name = std::format("spp_{:05}.pfm", samples_per_pixel);
+        std::ofstream file(dir / name, std::ios::binary);
+        if (!average.write_pfm(file)) {
+            throw std::runtime_error(std::format("Failed to write file: {}.", (dir / name).string()));
+        }
+        csv << std::format("{},{},{:.6f},{}\n", pass, samples_per_pixel, seconds, name) << std::flush;
+    });
+
+    if (!csv) {
+        throw std::runtime_error(std::format("Failed to write file: {}.", (dir / "snapshots.csv").string()));
+    }
+
+    return stats;
+}
 
 int main(int argc, char *argv[]) {
     argparse::ArgumentParser program("ray-tracer");
@@ -23,7 +63,7 @@ int main(int argc, char *argv[]) {
         .help("resolution specified as `<width>x<height>` or `<width>@<aspect_ratio_w>:<aspect_ratio_h>`.");
 
     program.add_argument("scene")
-        .help("loads YAML file specifiying scene.");
+        .help("loads YAML file specifiying scene, or a scene file written by `compile`.");
 
     program.add_argument("-r", "--render-settings")
         .help("loads YAML file specifiying rendering settings.");
@@ -51,8 +91,58 @@ int main(int argc, char *argv[]) {
         .help("height of the chunks when rendering with mutliple threads.")
         .scan<'i', int32_t>();
 
+    program.add_argument("--seed")
+        .help("seed of the per-chunk random streams.")
+        .scan<'i', uint64_t>();
+
+    program.add_argument("--no-packets")
+        .help("trace every camera ray on its own instead of in packets.")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--wavefront")
+        .help("shade paths in batches sorted by material instead of one at a time.")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--cache-dir")
+        .help("directory caching compiled YAML scenes between runs.");
+
+    program.add_argument("--server")
+        .help("submit the render to the server listening on this socket.");
+
+    program.add_argument("--heatmap")
+        .help("also write the render time of each chunk next to the output, as OUTPUT.heatmap.ppm and OUTPUT.tiles.csv.")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--trace")
+        .help("write a timeline of loading and rendering to this file, in Chrome trace format.");
+
+    program.add_argument("--capture-rays")
+        .help("record every ray intersected with the scene to this file, for `replay`.");
+
+    program.add_argument("--stats")
+        .help("write the traversal statistics to this JSON file (builds with -DRT_STATS only).");
+
+    program.add_argument("--pin")
+        .help("pin worker threads to CPUs, spread over the NUMA nodes, each node rendering its own range of chunks first.")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--numa")
+        .help("`replicate` loads a copy of the scene on every NUMA node (implies --pin), `interleave` spreads it over all nodes.");
+
+    program.add_argument("--snapshots")
+        .help("render in passes and write the running average after passes 1, 2, 4, ... and the last to this directory as PFM, listed in snapshots.csv.");
+
+    program.add_argument("--passes")
+        .help("number of passes with --snapshots; each takes an equal share of the samples.")
+        .default_value(uint32_t(16))
+        .scan<'i', uint32_t>();
+
     program.add_argument("-o", "--output")
-        .help("output file.");
+        .help("output file, PFM when it ends in .pfm and PPM otherwise.");
 
     try {
         program.parse_args(argc, argv);
@@ -62,6 +152,18 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
+    const CpuCount &cpus = CpuCount::get();
+    std::clog << std::format("Detected {} CPUs from {}.\n", cpus.count, cpus.source);
+
+    if (program.present("capture-rays")) {
+        RayCapture::start();
+    }
+
+    if (program.present("trace")) {
+        Trace::start();
+        Trace::name_thread("main");
+    }
+
     const auto resolution = program.get<std::string>("resolution");
     Image img;
     if (resolution.contains('@')) {
@@ -85,6 +187,23 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
+    if (program.get<bool>("heatmap") && !program.present("output")) {
+        std::cerr << "--heatmap needs an output file (-o).\n";
+        return EXIT_FAILURE;
+    }
+
+    if (program.get<bool>("heatmap") && program.present("snapshots")) {
+        std::cerr << "--heatmap can't be combined with --snapshots.\n";
+        return EXIT_FAILURE;
+    }
+
+#ifndef RT_STATS
+    if (program.present("stats")) {
+        std::cerr << "--stats needs a build with -DRT_STATS, e.g. `make stats`.\n";
+        return EXIT_FAILURE;
+    }
+#endif
+
     RenderSettings rs;
     if (auto file_name = program.present("render-settings")) {
         rs = LoadRenderSettings(*file_name);
@@ -102,34 +221,104 @@ int main(int argc, char *argv[]) {
         rs.max_depth_ = *max_depth;
     }
 
+    if (auto seed = program.present<uint64_t>("seed")) {
+        rs.seed_ = *seed;
+    }
+
+    if (program.get<bool>("--no-packets")) {
+        rs.packets_ = false;
+    }
+
+    if (program.get<bool>("--wavefront")) {
+        rs.integrator_ = Integrator::Wavefront;
+    }
+
+    const std::string numa = program.present("numa").value_or("");
+    if (!numa.empty() && numa != "replicate" && numa != "interleave") {
+        std::cerr << std::format("Unknown NUMA policy `{}`, expected `replicate` or `interleave`.\n", numa);
+        return EXIT_FAILURE;
+    }
+
+    if (program.get<bool>("--pin") || numa == "replicate") {
+        rs.pin_threads_ = true;
+    }
+
     if (auto chunk_width = program.present<int32_t>("chunk-width")) {
         rs.chunk_width_ = *chunk_width;
-    } else if (rs.chunk_width_ == 0) {
-        rs.chunk_width_ = img.width_ / img.ar_.w_;
-
     }
 
     if (auto chunk_height = program.present<int32_t>("chunk-height")) {
         rs.chunk_height_ = *chunk_height;
-    } else if (rs.chunk_height_ == 0) {
-        rs.chunk_height_ = img.height_ / img.ar_.h_;
     }
-    
-    int divisor = 2;
-    int max_divisor = std::sqrt(std::min(rs.chunk_width_, rs.chunk_height_));
-    while (int32_t(rs.num_threads * 16) > img.width_ * img.height_ / (rs.chunk_width_ * rs.chunk_height_) && divisor < max_divisor) {
-        if (rs.chunk_width_ % divisor == 0 && rs.chunk_height_ % divisor == 0) {
-            rs.chunk_width_ /= divisor;
-            rs.chunk_height_ /= divisor;
-        } else {
-            divisor++;
+
+    if (auto socket_path = program.present("server")) {
+        const auto output = program.present("output");
+        if (!output) {
+            std::cerr << "Rendering on a server requires an output file.\n";
+            return EXIT_FAILURE;
+        }
+
+        RenderJob job;
+        job.scene = std::filesystem::absolute(program.get("scene"));
+        job.width = img.width_;
+        job.height = img.height_;
+        if (auto file_name = program.present("camera-settings")) {
+            job.camera = LoadCamera(*file_name);
+        }
+        job.rs = rs;
+        job.output = std::filesystem::absolute(*output);
+
+        try {
+            const std::string reply = submit_job(*socket_path, job);
+            std::clog << reply;
+            return reply.starts_with("ok") ? EXIT_SUCCESS : EXIT_FAILURE;
+        } catch (const std::exception &err) {
+            std::cerr << err.what() << std::endl;
+            return EXIT_FAILURE;
         }
     }
 
-    Scene scene = LoadScene(program.get("scene"));
+    fit_chunks(rs, img);
+
+    // A replica must not share the pages of a mapped scene file with the
+    // other nodes, so compiled scenes are copied out of the mapping.
+    const auto scene_file_name = program.get("scene");
+    const bool copy = numa == "replicate";
+    const auto load_world = [&]() -> SceneFile::Loaded {
+        if (SceneFile::is_scene_file(scene_file_name)) {
+            return SceneFile::load(scene_file_name, copy);
+        } else if (auto cache_dir = program.present("cache-dir")) {
+            return SceneCache(*cache_dir).load(scene_file_name, copy);
+        }
+
+        Scene scene = LoadScene(scene_file_name);
+        return { scene.compile(), scene.cb_ };
+    };
+
+    // With --numa replicate, every node loads its own copy of the scene,
+    // textures included, so workers read only local memory.
+    std::vector<std::shared_ptr<CompiledScene>> replicas;
+    CameraBuilder cb;
+    try {
+        if (numa == "replicate") {
+            for (auto &loaded : Numa::on_each_node(load_world)) {
+                replicas.push_back(loaded.scene);
+                cb = loaded.cb;
+            }
+        } else {
+            Numa::interleave_memory(numa == "interleave");
+            const auto loaded = load_world();
+            Numa::interleave_memory(false);
+            replicas.push_back(loaded.scene);
+            cb = loaded.cb;
+        }
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
 
     if (auto file_name = program.present("camera-settings")) {
-        scene.cb_ = LoadCamera(*file_name);
+        cb = LoadCamera(*file_name);
     }
 
 
@@ -143,13 +332,47 @@ int main(int argc, char *argv[]) {
     // box_2 = std::make_shared<Translate>(box_2, Vec3<double>(130, 0, 65));
     // scene.add_object(box_2);
 
-    render(img, scene.camera(img), HittableList(scene.bvh()), rs);
+    std::vector<TileCost> tiles;
+    const auto rendering = Trace::now();
+    RenderStats stats;
+    if (auto dir = program.present("snapshots")) {
+        try {
+            stats = render_snapshots(img, cb.build(img), *replicas.front(), rs, program.get<uint32_t>("passes"), *dir);
+        } catch (const std::exception &err) {
+            std::cerr << err.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    } else {
+        std::vector<const Hittable*> scenes;
+        for (const auto &replica : replicas) {
+            scenes.push_back(replica.get());
+        }
+        stats = render(img, cb.build(img), scenes, rs, &tiles);
+    }
+    Trace::complete("render", "render", rendering, Trace::now());
+#ifdef RT_STATS
+    std::clog << stats.traversal;
+    if (auto file_name = program.present("stats")) {
+        std::ofstream file(*file_name);
+        if (!(file << stats.traversal.json() << '\n')) {
+            std::cerr << "Failed to write file: " << *file_name << ".\n";
+            return EXIT_FAILURE;
+        }
+    }
+#else
+    (void)stats;
+#endif
 
     if (auto file_name = program.present("output")) {
-        std::ofstream file(*file_name);
+        std::ofstream file(*file_name, std::ios::binary);
         if (file.is_open()) {
             std::clog << "Writing to file: " << *file_name << "...\n";
-            file << img;
+            TraceScope trace("encode image", "output");
+            if (std::filesystem::path(*file_name).extension() == ".pfm") {
+                img.write_pfm(file);
+            } else {
+                file << img;
+            }
             std::clog << "Successfully written to file!\n";
         } else {
             std::cerr << "Failed to open file: " << *file_name << ".\n";
@@ -160,5 +383,40 @@ int main(int argc, char *argv[]) {
         std::cout << img;
     }
 
+    if (program.get<bool>("heatmap")) {
+        const std::filesystem::path output = program.get("output");
+        const auto heatmap_name = std::filesystem::path(output).replace_extension(".heatmap.ppm");
+        const auto csv_name = std::filesystem::path(output).replace_extension(".tiles.csv");
+
+        std::ofstream heatmap_file(heatmap_name), csv_file(csv_name);
+        if (!(heatmap_file << tile_heatmap(tiles, img.width_, img.height_))) {
+            std::cerr << "Failed to write file: " << heatmap_name.string() << ".\n";
+            return EXIT_FAILURE;
+        }
+        if (!write_tile_csv(csv_file, tiles)) {
+            std::cerr << "Failed to write file: " << csv_name.string() << ".\n";
+            return EXIT_FAILURE;
+        }
+        std::clog << "Tile costs written to " << heatmap_name.string() << " and " << csv_name.string() << ".\n";
+    }
+
+    if (auto file_name = program.present("capture-rays")) {
+        try {
+            const uint64_t count = RayCapture::write(*file_name);
+            std::clog << std::format("Captured {} rays to {}.\n", count, *file_name);
+        } catch (const std::exception &err) {
+            std::cerr << err.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (auto file_name = program.present("trace")) {
+        std::ofstream file(*file_name);
+        if (!Trace::write(file)) {
+            std::cerr << "Failed to write file: " << *file_name << ".\n";
+            return EXIT_FAILURE;
+        }
+    }
+
     return EXIT_SUCCESS;
 }
@@ -5,27 +5,67 @@
 #include "texture.hpp"
 #include "yaml-cpp/node/convert.h"
 #include <cmath>
+#include <cstdint>
 #include <memory>
 
 class Material {
 public:
+    // Concrete type, so integrators can batch hits by material and call
+    // `scatter` without going through the vtable.
+    enum class Kind : uint8_t { Other, Lambertian, Metal, Dielectric, DiffuseLight, Isotropic };
+    static constexpr size_t NUM_KINDS = 6;
+
+    // What shading has to evaluate for a material.
+    enum Flags : uint8_t {
+        EMISSIVE = 1 << 0,  // `emitted` may be non-zero.
+        SCATTERS = 1 << 1,  // `scatter` may continue the path.
+        SPECULAR = 1 << 2,  // Scattered directions are (near) deterministic.
+    };
+
+    explicit Material(Kind kind = Kind::Other) : kind_(kind), flags_(default_flags(kind)) {}
     virtual ~Material() = default;
+
+    Kind kind() const { return kind_; }
+    uint8_t flags() const { return flags_; }
+    bool is_emissive() const { return flags_ & EMISSIVE; }
+    bool scatters() const { return flags_ & SCATTERS; }
     
-    virtual bool scatter(const Ray<double>& ray_in, const HitRecord& rec, Color &attenuation, Ray<double>& ray_out) const {
+    virtual bool scatter(const Ray<real>& ray_in, const HitRecord& rec, Color &attenuation, Ray<real>& ray_out) const {
         return false;
     }
 
-    virtual Color emitted(double u, double v, const Point3<double> &p) const {
+    virtual Color emitted(real u, real v, const Point3<real> &p) const {
         return Color();
     }
+
+private:
+    Kind kind_;
+    uint8_t flags_;
+
+    static constexpr uint8_t default_flags(Kind kind) {
+        switch (kind) {
+            case Kind::Lambertian:
+            case Kind::Isotropic:
+                return SCATTERS;
+            case Kind::Metal:
+            case Kind::Dielectric:
+                return SCATTERS | SPECULAR;
+            case Kind::DiffuseLight:
+                return EMISSIVE;
+            case Kind::Other:
+                break;
+        }
+
+        return EMISSIVE | SCATTERS;
+    }
 };
 
 class Lambertian : public Material {
 public:
-    Lambertian(const Color& albedo) : tex_(std::make_shared<SolidColorTexture>(albedo)) {}
-    Lambertian(std::shared_ptr<Texture> tex) : tex_(tex) {}
+    Lambertian(const Color& albedo) : Material(Kind::Lambertian), tex_(make_arena_shared<SolidColorTexture>(albedo)) {}
+    Lambertian(std::shared_ptr<Texture> tex) : Material(Kind::Lambertian), tex_(tex) {}
 
-    bool scatter(const Ray<double>& ray_in, const HitRecord& rec, Color &attenuation, Ray<double>& ray_out) const override {
+    bool scatter(const Ray<real>& ray_in, const HitRecord& rec, Color &attenuation, Ray<real>& ray_out) const override {
         auto scatter_direction = rec.normal + random_unit_vector();
         // Catch degenerate scatter_direction
         if (scatter_direction.near_zero()) {
@@ -42,13 +82,14 @@ public:
 private:
     std::shared_ptr<Texture> tex_;
     friend struct YAML::convert<std::shared_ptr<Lambertian>>;
+    friend class SceneFile;
 };
 
 class Metal : public Material {
 public:
-    Metal(const Color& color, double fuzz) : color_(color), fuzz_(fuzz < 1 ? fuzz : 1) {}
+    Metal(const Color& color, real fuzz) : Material(Kind::Metal), color_(color), fuzz_(fuzz < 1 ? fuzz : 1) {}
 
-    bool scatter(const Ray<double>& ray_in, const HitRecord& rec, Color &attenuation, Ray<double>& ray_out) const override {
+    bool scatter(const Ray<real>& ray_in, const HitRecord& rec, Color &attenuation, Ray<real>& ray_out) const override {
         const auto reflected = normalize(reflect(ray_in.direction(), rec.normal)) + (fuzz_ * random_unit_vector());
         ray_out = Ray(rec.p, reflected, ray_in.time());
         attenuation = color_;
@@ -60,23 +101,24 @@ public:
 
 private:
     Color color_;
-    double fuzz_;
+    real fuzz_;
     friend struct YAML::convert<std::shared_ptr<Metal>>;
+    friend class SceneFile;
 };
 
 class Dielectric : public Material {
 public:
-    Dielectric(double refraction_index) : refraction_index_(refraction_index) {}
+    Dielectric(real refraction_index) : Material(Kind::Dielectric), refraction_index_(refraction_index) {}
 
-    bool scatter(const Ray<double>& ray_in, const HitRecord& rec, Color &attenuation, Ray<double>& ray_out) const override {
+    bool scatter(const Ray<real>& ray_in, const HitRecord& rec, Color &attenuation, Ray<real>& ray_out) const override {
         attenuation = Color(1.0, 1.0, 1.0);
-        const double ri = rec.front_face ? (1.0 / refraction_index_) : refraction_index_;
+        const real ri = rec.front_face ? (1.0 / refraction_index_) : refraction_index_;
         const auto unit_dir = normalize(ray_in.direction());
         const auto cos_theta = std::fmin(dot(-unit_dir, rec.normal), 1.0);
         const auto sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
         const bool can_refract = ri * sin_theta <= 1.0;
 
-        Vec3<double> direction;
+        Vec3<real> direction;
         if (can_refract && reflectance(cos_theta, ri) <= random_double()) {
             // Refraction
             direction = refract(unit_dir, rec.normal, ri);
@@ -90,12 +132,15 @@ public:
     }
     
     inline static const std::string NAME = "dielectic";
+    // Also accepted when decoding; NAME keeps its spelling so existing
+    // files still load.
+    inline static const std::string ALIAS = "dielectric";
 
 private:
-    double refraction_index_;
+    real refraction_index_;
 
     // Schlick's approximation for reflectance
-    static double reflectance(double cos_theta, double refraction_index) {
+    static real reflectance(real cos_theta, real refraction_index) {
         auto r0 = (1.0 - refraction_index) / (1.0 + refraction_index);
         r0 = r0 * r0;
 
@@ -103,31 +148,34 @@ private:
     }
 
     friend struct YAML::convert<std::shared_ptr<Dielectric>>;
+    friend class SceneFile;
 };
 
 class DiffuseLight : public Material {
 public:
-    DiffuseLight(std::shared_ptr<Texture> tex) : tex_(tex) {}
-    DiffuseLight(const Color &color) : tex_(std::make_shared<SolidColorTexture>(color)) {}
+    DiffuseLight(std::shared_ptr<Texture> tex) : Material(Kind::DiffuseLight), tex_(tex) {}
+    DiffuseLight(const Color &color) : Material(Kind::DiffuseLight), tex_(make_arena_shared<SolidColorTexture>(color)) {}
 
-    Color emitted(double u, double v, const Point3<double> &p) const override {
+    Color emitted(real u, real v, const Point3<real> &p) const override {
         return tex_->value(u, v, p);
     }
 
     inline static const std::string NAME = "diffuse-light";
+    inline static const std::string ALIAS = "diffuse_light";   // Also accepted when decoding.
 private:
     std::shared_ptr<Texture> tex_;
 
     friend struct YAML::convert<std::shared_ptr<DiffuseLight>>;
+    friend class SceneFile;
 };
 
 class Isotropic : public Material {
 public:
-    Isotropic(std::shared_ptr<Texture> tex) : tex_(tex) {}
-    Isotropic(const Color &color) : tex_(std::make_shared<SolidColorTexture>(color)) {}
+    Isotropic(std::shared_ptr<Texture> tex) : Material(Kind::Isotropic), tex_(tex) {}
+    Isotropic(const Color &color) : Material(Kind::Isotropic), tex_(make_arena_shared<SolidColorTexture>(color)) {}
 
-    bool scatter(const Ray<double> &ray_in, const HitRecord &rec, Color &attenuation, Ray<double> &ray_out) const override {
-        ray_out = Ray<double>(rec.p, random_unit_vector(), ray_in.time());
+    bool scatter(const Ray<real> &ray_in, const HitRecord &rec, Color &attenuation, Ray<real> &ray_out) const override {
+        ray_out = Ray<real>(rec.p, random_unit_vector(), ray_in.time());
         attenuation = tex_->value(rec.u, rec.v, rec.p);
         return true;
     }
@@ -138,4 +186,38 @@ private:
     std::shared_ptr<Texture> tex_;
 
     friend struct YAML::convert<std::shared_ptr<Isotropic>>;
+    friend class SceneFile;
 };
+
+// `mat.scatter(...)` dispatched on the material's kind; the known types are
+// called directly instead of through the vtable.
+inline bool scatter(const Material &mat, const Ray<real>& ray_in, const HitRecord& rec, Color &attenuation, Ray<real>& ray_out) {
+    switch (mat.kind()) {
+        case Material::Kind::Lambertian:
+            return static_cast<const Lambertian&>(mat).Lambertian::scatter(ray_in, rec, attenuation, ray_out);
+        case Material::Kind::Metal:
+            return static_cast<const Metal&>(mat).Metal::scatter(ray_in, rec, attenuation, ray_out);
+        case Material::Kind::Dielectric:
+            return static_cast<const Dielectric&>(mat).Dielectric::scatter(ray_in, rec, attenuation, ray_out);
+        case Material::Kind::Isotropic:
+            return static_cast<const Isotropic&>(mat).Isotropic::scatter(ray_in, rec, attenuation, ray_out);
+        case Material::Kind::DiffuseLight:
+            return false;
+        case Material::Kind::Other:
+            break;
+    }
+
+    return mat.scatter(ray_in, rec, attenuation, ray_out);
+}
+
+// `mat.emitted(...)`, dispatched like `scatter`.
+inline Color emitted(const Material &mat, real u, real v, const Point3<real> &p) {
+    switch (mat.kind()) {
+        case Material::Kind::DiffuseLight:
+            return static_cast<const DiffuseLight&>(mat).DiffuseLight::emitted(u, v, p);
+        case Material::Kind::Other:
+            return mat.emitted(u, v, p);
+        default:
+            return Color();
+    }
+}
@@ -0,0 +1,189 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bbox.hpp"
+#include "camera.hpp"
+#include "constant_medium.hpp"
+#include "image.hpp"
+#include "perlin.hpp"
+#include "quad.hpp"
+#include "rtw_stb_image.hpp"
+#include "sphere.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+#include "vec3.hpp"
+#include "argparse/argparse.hpp"
+
+// Inputs are drawn once from a fixed seed and cycled through, so every run
+// and every build measures the same work.
+constexpr size_t NUM_INPUTS = 1 << 10;
+constexpr uint64_t SEED = 1;
+
+struct Inputs {
+    std::vector<Ray<real>> rays;            // From a sphere of radius 5 towards the unit cube around the origin.
+    std::vector<Point3<real>> points;       // In [0, 10)^3.
+    std::vector<Vec3<real>> directions;     // Unit vectors.
+    std::vector<Vec3<real>> normals;        // Unit vectors facing away from `directions`.
+    std::vector<real> u, v;                 // In [0, 1).
+
+    Inputs() {
+        seed_random(SEED);
+        for (size_t i = 0; i < NUM_INPUTS; i++) {
+            const Point3<real> origin = Point3<real>() + 5 * random_unit_vector();
+            const Point3<real> target(random_double(-1.5, 1.5), random_double(-1.5, 1.5), random_double(-1.5, 1.5));
+            rays.emplace_back(origin, normalize(target - origin), random_double());
+
+            points.emplace_back(random_double(0, 10), random_double(0, 10), random_double(0, 10));
+
+            const Vec3<real> d = random_unit_vector(), n = random_unit_vector();
+            directions.push_back(d);
+            normals.push_back(dot(d, n) < 0 ? n : -n);
+
+            u.push_back(random_double());
+            v.push_back(random_double());
+        }
+    }
+};
+
+// Result sink the optimizer can't see through.
+static volatile real sink;
+
+// Average time of one call of `op` over `iterations` calls, in nanoseconds.
+template<typename F>
+double time_loop(F &op, size_t iterations) {
+    const auto start = std::chrono::steady_clock::now();
+    real total = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        total += op(i & (NUM_INPUTS - 1));
+    }
+    const auto end = std::chrono::steady_clock::now();
+    sink = total;
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+struct Kernel {
+    const char *name;
+    std::function<double(size_t)> run;      // Runs the given number of iterations, returns ns/op.
+};
+
+template<typename F>
+Kernel kernel(const char *name, F op) {
+    return { name, [op](size_t iterations) mutable { return time_loop(op, iterations); } };
+}
+
+// Two-sided 95% Student t quantiles for 1 to 30 degrees of freedom.
+static double t_quantile(size_t df) {
+    static const double TABLE[] = {
+        12.71, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    return df == 0 ? INFINITY : df <= std::size(TABLE) ? TABLE[df - 1] : 1.96;
+}
+
+// Times the hot primitives in isolation, `--runs` samples of at least
+// `--min-time` each, and prints the mean ns/op with its 95% confidence
+// interval. Checks changes to e.g. bbox.hpp without a full render.
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser program("microbench");
+
+    program.add_argument("-f", "--filter")
+        .help("only run kernels whose name contains this.")
+        .default_value(std::string());
+
+    program.add_argument("-r", "--runs")
+        .help("number of timed samples per kernel.")
+        .default_value(size_t(15))
+        .scan<'i', size_t>();
+
+    program.add_argument("--min-time")
+        .help("minimum duration of one sample, in milliseconds.")
+        .default_value(size_t(20))
+        .scan<'i', size_t>();
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return EXIT_FAILURE;
+    }
+
+    const std::string filter = program.get("filter");
+    const size_t runs = std::max<size_t>(program.get<size_t>("runs"), 2);
+    const double min_time_ns = program.get<size_t>("min-time") * 1e6;
+
+    const Inputs in;
+    const auto mat = std::make_shared<Lambertian>(Color(0.5, 0.5, 0.5));
+    const BBox3 bbox(Point3<real>(-1, -1, -1), Point3<real>(1, 1, 1));
+    const Sphere sphere(Point3<real>(), 1, mat);
+    const Quad quad(Point3<real>(-1, -1, 0), Vec3<real>(2, 0, 0), Vec3<real>(0, 2, 0), mat);
+    const Box box(Point3<real>(-1, -1, -1), Point3<real>(1, 1, 1), mat);
+    const ConstantMedium medium(std::make_shared<Sphere>(Point3<real>(), 1, mat), 0.5, Color(1, 1, 1));
+    const Perlin perlin;
+    const ImageTexture image("earthmap.jpg");
+    const bool image_loaded = RTWImage("earthmap.jpg").width() > 0;
+    const Image img(400, 225);
+    const Camera camera = CameraBuilder().build(img);
+
+    const auto hit_t = [](const Hittable &obj, const Ray<real> &ray) {
+        HitRecord rec;
+        return obj.hit(ray, Interval(0.001, infinity), rec) ? rec.t : 0;
+    };
+
+    const Kernel kernels[] = {
+        kernel("BBox3::hit", [&](size_t i) -> real { return bbox.hit(in.rays[i], Interval(0.001, infinity)); }),
+        kernel("Sphere::hit", [&](size_t i) { return hit_t(sphere, in.rays[i]); }),
+        kernel("Quad::hit", [&](size_t i) { return hit_t(quad, in.rays[i]); }),
+        kernel("Box::hit", [&](size_t i) { return hit_t(box, in.rays[i]); }),
+        kernel("ConstantMedium::hit", [&](size_t i) { return hit_t(medium, in.rays[i]); }),
+        kernel("Perlin::turb", [&](size_t i) { return perlin.turb(in.points[i], 7); }),
+        image_loaded ? kernel("ImageTexture::value", [&](size_t i) { return image.value(in.u[i], in.v[i], in.points[i]).r(); }) : Kernel{ "ImageTexture::value", nullptr },
+        kernel("random_unit_vector", [](size_t) { return random_unit_vector().x(); }),
+        kernel("reflect", [&](size_t i) { return reflect(in.directions[i], in.normals[i]).x(); }),
+        kernel("refract", [&](size_t i) { return refract(in.directions[i], in.normals[i], 1 / 1.5).x(); }),
+        kernel("Camera::cast_ray_at_pixel_loc", [&](size_t i) { return camera.cast_ray_at_pixel_loc(i % img.height_, i % img.width_).direction().x(); }),
+    };
+
+    std::cout << std::format("{:<30} {:>10} {:>10} {:>10}   {}\n", "kernel", "ns/op", "±95%", "min", "iterations");
+    for (const Kernel &k : kernels) {
+        if (!std::string(k.name).contains(filter)) continue;
+        if (k.run == nullptr) {
+            std::cout << std::format("{:<30} {:>10}\n", k.name, "skipped");
+            continue;
+        }
+
+        // Warm up, then grow the sample until it lasts at least min_time.
+        size_t iterations = NUM_INPUTS;
+        while (k.run(iterations) * iterations < min_time_ns && iterations < (size_t(1) << 40)) {
+            iterations *= 2;
+        }
+
+        seed_random(SEED);
+        std::vector<double> samples(runs);
+        for (auto &sample : samples) {
+            sample = k.run(iterations);
+        }
+
+        double mean = 0, min = INFINITY;
+        for (const double s : samples) {
+            mean += s / runs;
+            min = std::min(min, s);
+        }
+        double variance = 0;
+        for (const double s : samples) {
+            variance += (s - mean) * (s - mean) / (runs - 1);
+        }
+        const double ci = t_quantile(runs - 1) * std::sqrt(variance / runs);
+
+        std::cout << std::format("{:<30} {:>10.2f} {:>9.2f}% {:>10.2f}   {}\n", k.name, mean, 100 * ci / mean, min, iterations);
+    }
+
+    return EXIT_SUCCESS;
+}
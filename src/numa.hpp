@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// NUMA topology from /sys/devices/system/node, and placement of worker
+// threads and memory on it. Without NUMA information the machine is one node
+// holding every CPU the process may run on. Uses the kernel interface
+// directly, so there's no libnuma dependency.
+class Numa {
+public:
+    // The CPUs of each node the process may run on; nodes without any are
+    // left out.
+    static const std::vector<std::vector<uint32_t>>& nodes() { return topology().cpus; }
+
+    static size_t num_nodes() { return nodes().size(); }
+
+    // The node the calling thread was pinned to, 0 if it wasn't.
+    static size_t current_node() { return current_node_; }
+
+    // Pins the calling thread to one CPU, spreading workers across the nodes
+    // round robin so each gets an equal share: worker 0 to the first CPU of
+    // node 0, worker 1 to the first of node 1, and so on.
+    static void pin_worker(size_t worker) {
+        const size_t node = worker % num_nodes();
+        const auto &cpus = nodes()[node];
+        pin_current_thread({ cpus[(worker / num_nodes()) % cpus.size()] });
+        current_node_ = node;
+    }
+
+    // Pins the calling thread to every CPU of `node`.
+    static void pin_to_node(size_t node) {
+        pin_current_thread(nodes()[node]);
+        current_node_ = node;
+    }
+
+    // Spreads the pages the calling thread allocates from now on across all
+    // nodes, or back to the default of the node that first touches them.
+    static void interleave_memory(bool interleave) {
+#ifdef __linux__
+        if (!interleave) {
+            syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+            return;
+        }
+
+        std::vector<unsigned long> mask(MAX_NODES / (8 * sizeof(unsigned long)));
+        for (const uint32_t node : topology().ids) {
+            mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        }
+        syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, mask.data(), MAX_NODES);
+#else
+        (void)interleave;
+#endif
+    }
+
+    // Calls `make` once on every node, on a thread pinned to it, so the
+    // memory it allocates is local to that node. Returns the results in node
+    // order; rethrows the first exception `make` threw.
+    template<typename F>
+    static auto on_each_node(F make) {
+        std::vector<decltype(make())> results(num_nodes());
+        std::vector<std::exception_ptr> errors(num_nodes());
+        std::vector<std::thread> threads;
+        for (size_t node = 0; node < num_nodes(); node++) {
+            threads.emplace_back([&, node] {
+                pin_to_node(node);
+                try {
+                    results[node] = make();
+                } catch (...) {
+                    errors[node] = std::current_exception();
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        for (const auto &error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+
+        return results;
+    }
+
+    // Parses a list such as "0-3,8,10-11".
+    static std::vector<uint32_t> parse_cpu_list(const std::string &list) {
+        std::vector<uint32_t> cpus;
+        std::istringstream ranges(list);
+        for (std::string range; std::getline(ranges, range, ',');) {
+            const auto dash = range.find('-');
+            const uint32_t first = std::stoul(range.substr(0, dash));
+            const uint32_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            for (uint32_t cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+
+        return cpus;
+    }
+
+private:
+    static constexpr size_t MAX_NODES = 1024;
+
+    static inline thread_local size_t current_node_ = 0;
+
+    static void pin_current_thread(const std::vector<uint32_t> &cpus) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const uint32_t cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        sched_setaffinity(0, sizeof(set), &set);
+#else
+        (void)cpus;
+#endif
+    }
+
+    struct Topology {
+        std::vector<std::vector<uint32_t>> cpus;
+        std::vector<uint32_t> ids;      // Kernel node id of each entry of `cpus`.
+    };
+
+    static const Topology& topology() {
+        static const Topology topology = detect();
+        return topology;
+    }
+
+    static Topology detect() {
+        std::vector<uint32_t> allowed;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) allowed.push_back(cpu);
+            }
+        }
+#endif
+        if (allowed.empty()) {
+            for (uint32_t cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++) {
+                allowed.push_back(cpu);
+            }
+        }
+
+        std::error_code err;
+        std::vector<uint32_t> ids;
+        for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", err)) {
+            const std::string name = entry.path().filename().string();
+            if (name.starts_with("node") && name.size() > 4 && std::isdigit(static_cast<unsigned char>(name[4]))) {
+                ids.push_back(std::stoul(name.substr(4)));
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+
+        Topology topology;
+        for (const uint32_t id : ids) {
+            std::ifstream file(std::format("/sys/devices/system/node/node{}/cpulist", id));
+            std::string list;
+            std::getline(file, list);
+
+            std::vector<uint32_t> cpus;
+            for (const uint32_t cpu : list.empty() ? std::vector<uint32_t>() : parse_cpu_list(list)) {
+                if (std::binary_search(allowed.begin(), allowed.end(), cpu)) cpus.push_back(cpu);
+            }
+            if (!cpus.empty()) {
+                topology.cpus.push_back(std::move(cpus));
+                topology.ids.push_back(id);
+            }
+        }
+
+        if (topology.cpus.empty()) {
+            topology = { { allowed }, { 0 } };
+        }
+
+        return topology;
+    }
+};
@@ -7,7 +7,7 @@ class Perlin {
 public:
     Perlin() {
         for (int i = 0; i < point_count; i++) {
-            randvec_[i] = Vec3<double>::random(-1, 1);
+            randvec_[i] = Vec3<real>::random(-1, 1);
         }
 
         perlin_generate_perm(perm_x_);
@@ -15,7 +15,7 @@ public:
         perlin_generate_perm(perm_z_);
     }
 
-    double noise(const Point3<double> &p) const {
+    real noise(const Point3<real> &p) const {
         auto u = p.x() - std::floor(p.x());
         auto v = p.y() - std::floor(p.y());
         auto w = p.z() - std::floor(p.z());
@@ -24,7 +24,7 @@ public:
         const auto j = static_cast<int>(std::floor(p.y()));
         const auto k = static_cast<int>(std::floor(p.z()));
 
-        Vec3<double> c[2][2][2];
+        Vec3<real> c[2][2][2];
 
         for (int di = 0; di < 2; di++) {
             for (int dj = 0; dj < 2; dj++) {
@@ -37,7 +37,7 @@ public:
         return perlin_interp(c, u, v, w);
     }
 
-    double turb(const Point3<double> p, int depth) const {
+    real turb(const Point3<real> p, int depth) const {
         auto acc = 0.0;
         auto temp_p = p;
         auto weight = 1.0;
@@ -53,7 +53,7 @@ public:
 
 private:
     static const int point_count = 256;
-    Vec3<double> randvec_[point_count];
+    Vec3<real> randvec_[point_count];
     int perm_x_[point_count];
     int perm_y_[point_count];
     int perm_z_[point_count];
@@ -75,7 +75,7 @@ private:
         }
     }
 
-    static double trilinear_interp(double c[2][2][2], double u, double v, double w) {
+    static real trilinear_interp(real c[2][2][2], real u, real v, real w) {
         auto acc = 0.0;
         for (int i = 0; i < 2; i++) {
             for (int j = 0; j < 2; j++) {
@@ -91,7 +91,7 @@ private:
         return acc;
     }
 
-    static double perlin_interp(Vec3<double> c[2][2][2], double u, double v, double w) {
+    static real perlin_interp(Vec3<real> c[2][2][2], real u, real v, real w) {
         const auto uu = u * u * (3 - 2 * u);
         const auto vv = v * v * (3 - 2 * v);
         const auto ww = w * w * (3 - 2 * w);
@@ -100,7 +100,7 @@ private:
         for (int i = 0; i < 2; i++) {
             for (int j = 0; j < 2; j++) {
                 for (int k = 0; k < 2; k++) {
-                    Vec3<double> weight_vec(u - i, v - j, w - k);
+                    Vec3<real> weight_vec(u - i, v - j, w - k);
                     acc += (i * uu + (1 - i) * (1 - uu)) 
                         * (j * vv + (1 - j) * (1 - vv))
                         * (k * ww + (1 - k) * (1 - ww))
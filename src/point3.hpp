@@ -4,7 +4,7 @@
 
 template<typename T>
 struct Point3 {
-    T elem[3];
+    vec3_storage_t<T> elem;
 
     Point3() : elem{0, 0, 0} {}
     Point3(const Vec3<T> &v) : elem{v.elem[0], v.elem[1], v.elem[2]} {}
@@ -47,10 +47,10 @@ template<typename T>
 Point3<T> operator-(const Vec3<T> &v, const Point3<T> &p) { return v - Vec3<T>(p); }
 
 template<typename T>
-Point3<T> operator*(const Point3<T> &p, double t) { return Vec3<T>(p) * t;}
+Point3<T> operator*(const Point3<T> &p, real t) { return Vec3<T>(p) * t;}
 
 template<typename T>
-Point3<T> operator*(double t, const Point3<T> &p) { return p * t; }
+Point3<T> operator*(real t, const Point3<T> &p) { return p * t; }
 
 template<typename U, typename V>
 Vec3<decltype(U() - V())> operator-(const Point3<U> &u, const Point3<V> &v) { return Vec3<U>(u) - Vec3<V>(v); }
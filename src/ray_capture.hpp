@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "interval.hpp"
+#include "ray.hpp"
+
+// One ray as intersected during a render, stored in single precision.
+struct CapturedRay {
+    float origin[3];
+    float direction[3];
+    float time;
+    float t_min, t_max;
+    uint32_t depth;     // 0 for camera rays.
+
+    Ray<real> ray() const {
+        return Ray<real>(Point3<real>(origin[0], origin[1], origin[2]), Vec3<real>(direction[0], direction[1], direction[2]), time);
+    }
+
+    Interval interval() const { return Interval(t_min, t_max); }
+};
+
+// Records every ray a render intersects with the scene, for the `replay`
+// tool. Recording is off until `start`; until then `record` costs a
+// thread-local load. Rays are buffered per chunk and written in chunk order,
+// so the same render settings produce the same file.
+//
+// File: the header below followed by `count` CapturedRay records.
+class RayCapture {
+public:
+    static constexpr char MAGIC[8] = {'R', 'T', 'R', 'A', 'Y', 'S', '\n', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t count;
+    };
+
+    static void start() { enabled_ = true; }
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Identifies a piece of a render: its chunk, first row and first sample
+    // block.
+    using Key = std::tuple<int32_t, int32_t, int32_t>;
+
+    // Sends the rays recorded on this thread to a chunk's buffer while alive.
+    class Chunk {
+    public:
+        // Chunks are written in order of `key`. Renders run one after another
+        // (e.g. the passes of a progressive render) reuse keys; their rays are
+        // appended in the order the renders ran.
+        explicit Chunk(const Key &key) : key_(key) {
+            if (enabled()) buffer_ = &rays_;
+        }
+
+        ~Chunk() {
+            if (buffer_ != &rays_) return;
+
+            buffer_ = nullptr;
+            std::lock_guard lock(mutex_);
+            auto &rays = chunks_[key_];
+            if (rays.empty()) {
+                rays = std::move(rays_);
+            } else {
+                rays.insert(rays.end(), rays_.begin(), rays_.end());
+            }
+        }
+
+        Chunk(const Chunk &) = delete;
+        Chunk& operator=(const Chunk &) = delete;
+
+    private:
+        Key key_;
+        std::vector<CapturedRay> rays_;
+    };
+
+    static void record(const Ray<real> &ray, const Interval &ray_t, int32_t depth) {
+        if (buffer_ == nullptr) return;
+
+        const auto &o = ray.origin();
+        const auto &d = ray.direction();
+        buffer_->push_back({
+            { static_cast<float>(o[0]), static_cast<float>(o[1]), static_cast<float>(o[2]) },
+            { static_cast<float>(d[0]), static_cast<float>(d[1]), static_cast<float>(d[2]) },
+            static_cast<float>(ray.time()),
+            static_cast<float>(ray_t.min), static_cast<float>(ray_t.max),
+            static_cast<uint32_t>(depth),
+        });
+    }
+
+    // Writes the rays recorded so far. Throws `std::runtime_error` if the file
+    // can't be written.
+    static uint64_t write(const std::string &file_name) {
+        std::lock_guard lock(mutex_);
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.record_size = sizeof(CapturedRay);
+        for (const auto &[index, rays] : chunks_) {
+            header.count += rays.size();
+        }
+
+        std::ofstream file(file_name, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto &[index, rays] : chunks_) {
+            file.write(reinterpret_cast<const char*>(rays.data()), rays.size() * sizeof(CapturedRay));
+        }
+
+        if (!file) {
+            throw std::runtime_error(std::format("Failed to write ray file: {}.", file_name));
+        }
+
+        return header.count;
+    }
+
+    // Reads a file written by `write`. Throws `std::runtime_error` if it isn't
+    // one or was written with a different record layout.
+    static std::vector<CapturedRay> read(const std::string &file_name) {
+        std::ifstream file(file_name, std::ios::binary);
+        Header header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error(std::format("Not a ray file: {}.", file_name));
+        }
+        if (header.version != VERSION || header.record_size != sizeof(CapturedRay)) {
+            throw std::runtime_error(std::format("Unsupported ray file: {} (version {}, record size {}).", file_name, header.version, header.record_size));
+        }
+
+        // Check the count against the file before allocating for it.
+        const std::streamoff records = file.tellg();
+        file.seekg(0, std::ios::end);
+        const uint64_t available = static_cast<uint64_t>(file.tellg() - records) / sizeof(CapturedRay);
+        file.seekg(records);
+        if (header.count > available) {
+            throw std::runtime_error(std::format("Truncated ray file: {}.", file_name));
+        }
+
+        std::vector<CapturedRay> rays(header.count);
+        if (!file.read(reinterpret_cast<char*>(rays.data()), rays.size() * sizeof(CapturedRay))) {
+            throw std::runtime_error(std::format("Truncated ray file: {}.", file_name));
+        }
+
+        return rays;
+    }
+
+private:
+    static inline std::atomic<bool> enabled_ = false;
+    static inline thread_local std::vector<CapturedRay> *buffer_ = nullptr;
+    static inline std::mutex mutex_;
+    static inline std::map<Key, std::vector<CapturedRay>> chunks_;
+};
@@ -1,23 +1,52 @@
 #include "render.hpp"
+#include "compiled_scene.hpp"
 #include "image.hpp"
 #include "material.hpp"
+#include "ray_capture.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <vector>
 
-Color ray_color(const Ray<double> &ray, const Hittable &world, const Color &background, int32_t depth, int32_t max_depth);
-void render_chunk(const Camera& cam, const HittableList& scene, ImageChunk img);
+Color ray_color(const Ray<real> &ray, const Hittable &world, const Color &background, int32_t depth, int32_t max_depth);
+Color shade(const Ray<real> &ray, const HitRecord &rec, const Hittable &world, const Color &background, int32_t depth, int32_t max_depth);
+void render_chunk(const Camera& cam, const Hittable& scene, const RenderSettings &rs, ImageChunk img);
+void render_chunk_packets(const Camera& cam, const CompiledScene& scene, const RenderSettings &rs, ImageChunk img);
+void render_chunk_wavefront(const Camera& cam, const Hittable& scene, const RenderSettings &rs, ImageChunk img);
 
-Color ray_color(const Ray<double> &ray, const Hittable &world, const Color &background, int32_t depth, int32_t max_depth) {
-    if (depth >= max_depth) return Color();
+// Rays this thread has intersected with the scene.
+static thread_local uint64_t rays_traced = 0;
+
+Color ray_color(const Ray<real> &ray, const Hittable &world, const Color &background, int32_t depth, int32_t max_depth) {
+    if (depth >= max_depth) {
+        RT_STAT(paths_depth_limited++);
+        return Color();
+    }
 
     HitRecord rec;
-    if (!world.hit(ray, Interval(0.001, infinity), rec)) {
+    const Interval ray_t(0.001, infinity);
+    rays_traced++;
+    RT_STAT(rays_by_depth[TraversalStats::depth_bucket(depth)]++);
+    RayCapture::record(ray, ray_t, depth);
+    if (!world.hit(ray, ray_t, rec)) {
+        RT_STAT(paths_escaped++);
         return background;
     }
 
-    const Color color_emitted = rec.mat->emitted(rec.u, rec.v, rec.p);
+    return shade(ray, rec, world, background, depth, max_depth);
+}
+
+// Light leaving the surface hit at `rec` towards the origin of `ray`.
+Color shade(const Ray<real> &ray, const HitRecord &rec, const Hittable &world, const Color &background, int32_t depth, int32_t max_depth) {
+    const Material &mat = *rec.mat;
+    const Color color_emitted = mat.is_emissive() ? emitted(mat, rec.u, rec.v, rec.p) : Color();
 
-    Ray<double> scattered;
+    Ray<real> scattered;
     Color attenuation;
-    if (!rec.mat->scatter(ray, rec, attenuation, scattered)) {
+    if (!mat.scatters() || !scatter(mat, ray, rec, attenuation, scattered)) {
+        RT_STAT(paths_absorbed++);
         return color_emitted;
     }
 
@@ -26,40 +55,433 @@ Color ray_color(const Ray<double> &ray, const Hittable &world, const Color &back
     return color_emitted + color_scattered;
 }
 
-void render_chunk(const Camera& cam, const HittableList& scene, const RenderSettings &rs, ImageChunk img) {
+void render_chunk(const Camera& cam, const Hittable& scene, const RenderSettings &rs, ImageChunk img) {
+    if (rs.integrator_ == Integrator::Wavefront) {
+        render_chunk_wavefront(cam, scene, rs, img);
+        return;
+    }
+
+    if (const auto compiled = dynamic_cast<const CompiledScene*>(&scene); compiled && rs.packets_) {
+        render_chunk_packets(cam, *compiled, rs, img);
+        return;
+    }
+
     for (int32_t i = img.x; i < img.x + img.height; i++) {
         for (int32_t j = img.y; j < img.y + img.width; j++) {
             Color pixel_color(0.0, 0.0, 0.0);
             for (int32_t k = 0; k < rs.samples_per_pixel_; k++) {
-                Ray<double> ray = cam.cast_ray_at_pixel_loc(i, j);
+                Ray<real> ray = cam.cast_ray_at_pixel_loc(i, j);
                 pixel_color += ray_color(ray, scene, cam.background_, 0, rs.max_depth_);
             }
 
-            img.pixels[i][j] = pixel_color * rs.pixel_color_scale_;
+            img.at(i, j) = pixel_color * rs.pixel_color_scale_;
+        }
+    }
+}
+
+// Traces the camera rays of each 4x2 pixel block as one packet. Every ray
+// continues on its own from its first hit.
+void render_chunk_packets(const Camera& cam, const CompiledScene& scene, const RenderSettings &rs, ImageChunk img) {
+    constexpr int32_t PACKET_WIDTH = 4, PACKET_HEIGHT = 2;
+    static_assert(PACKET_WIDTH * PACKET_HEIGHT <= CompiledScene::PACKET_SIZE);
+
+    Ray<real> rays[CompiledScene::PACKET_SIZE];
+    HitRecord recs[CompiledScene::PACKET_SIZE];
+    bool hits[CompiledScene::PACKET_SIZE];
+
+    for (int32_t i0 = img.x; i0 < img.x + img.height; i0 += PACKET_HEIGHT) {
+        for (int32_t j0 = img.y; j0 < img.y + img.width; j0 += PACKET_WIDTH) {
+            const int32_t rows = std::min(PACKET_HEIGHT, img.x + img.height - i0);
+            const int32_t cols = std::min(PACKET_WIDTH, img.y + img.width - j0);
+            const size_t count = rows * cols;
+
+            Color pixel_colors[CompiledScene::PACKET_SIZE];
+            for (int32_t k = 0; k < rs.samples_per_pixel_ && rs.max_depth_ > 0; k++) {
+                for (int32_t r = 0; r < rows; r++) {
+                    for (int32_t c = 0; c < cols; c++) {
+                        rays[r * cols + c] = cam.cast_ray_at_pixel_loc(i0 + r, j0 + c);
+                    }
+                }
+
+                const Interval ray_t(0.001, infinity);
+                for (size_t n = 0; n < count; n++) {
+                    RayCapture::record(rays[n], ray_t, 0);
+                }
+
+                scene.hit_packet(rays, count, ray_t, recs, hits);
+                rays_traced += count;
+                RT_STAT(rays_by_depth[0] += count);
+
+                for (size_t n = 0; n < count; n++) {
+                    RT_STAT(paths_escaped += !hits[n]);
+                    pixel_colors[n] += hits[n] ? shade(rays[n], recs[n], scene, cam.background_, 0, rs.max_depth_) : cam.background_;
+                }
+            }
+
+            for (int32_t r = 0; r < rows; r++) {
+                for (int32_t c = 0; c < cols; c++) {
+                    img.at(i0 + r, j0 + c) = pixel_colors[r * cols + c] * rs.pixel_color_scale_;
+                }
+            }
+        }
+    }
+}
+
+// Paths of one wavefront in structure-of-arrays form. `pixel` indexes the
+// chunk's pixels row by row.
+struct PathStates {
+    std::vector<Ray<real>> rays;
+    std::vector<Color> throughput;
+    std::vector<uint32_t> pixel;
+
+    size_t size() const { return rays.size(); }
+
+    void clear() {
+        rays.clear();
+        throughput.clear();
+        pixel.clear();
+    }
+
+    void push(const Ray<real> &ray, const Color &color, uint32_t p) {
+        rays.push_back(ray);
+        throughput.push_back(color);
+        pixel.push_back(p);
+    }
+};
+
+// Scatters the paths in `queue`, all of which hit a material of type `M`,
+// and appends the ones that continue to `next`. The qualified call skips the
+// vtable.
+template<typename M>
+void scatter_queue(const std::vector<uint32_t> &queue, const PathStates &paths, const std::vector<HitRecord> &recs, PathStates &next) {
+    for (const uint32_t n : queue) {
+        const HitRecord &rec = recs[n];
+        const M &mat = static_cast<const M&>(*rec.mat);
+
+        Ray<real> scattered;
+        Color attenuation;
+        if (mat.M::scatter(paths.rays[n], rec, attenuation, scattered)) {
+            next.push(scattered, paths.throughput[n] * attenuation, paths.pixel[n]);
+        } else {
+            RT_STAT(paths_absorbed++);
         }
     }
 }
 
-void render(Image &img, const Camera& cam, const HittableList& scene, const RenderSettings &rs) {
-    RenderTaskGenerator gen(img, cam, scene, rs);
-    ThreadPool pool(gen, rs.num_threads);
+// Renders the chunk in wavefronts of up to WAVEFRONT_SIZE paths. Each bounce
+// runs as separate stages over the whole wavefront: intersect every path,
+// bucket the hits by material kind, then shade each bucket in its own loop,
+// which produces the paths of the next bounce.
+void render_chunk_wavefront(const Camera& cam, const Hittable& scene, const RenderSettings &rs, ImageChunk img) {
+    constexpr size_t WAVEFRONT_SIZE = 1 << 13;
+
+    const size_t num_pixels = img.width * img.height;
+    const size_t num_paths = num_pixels * rs.samples_per_pixel_;
+
+    std::vector<Color> pixel_colors(num_pixels);
+    PathStates paths, next;
+    std::vector<HitRecord> recs;
+    std::array<std::vector<uint32_t>, Material::NUM_KINDS> queues;
+
+    for (size_t first = 0; first < num_paths; first += WAVEFRONT_SIZE) {
+        const size_t last = std::min(num_paths, first + WAVEFRONT_SIZE);
+
+        // Generate camera rays
+        paths.clear();
+        for (size_t n = first; n < last; n++) {
+            const uint32_t p = n / rs.samples_per_pixel_;
+            paths.push(cam.cast_ray_at_pixel_loc(img.x + p / img.width, img.y + p % img.width), Color(1.0, 1.0, 1.0), p);
+        }
+
+        for (int32_t depth = 0; depth < rs.max_depth_ && paths.size() > 0; depth++) {
+            // Intersect
+            recs.resize(paths.size());
+            for (auto &queue : queues) {
+                queue.clear();
+            }
+
+            rays_traced += paths.size();
+            RT_STAT(rays_by_depth[TraversalStats::depth_bucket(depth)] += paths.size());
+            const Interval ray_t(0.001, infinity);
+            for (size_t n = 0; n < paths.size(); n++) {
+                RayCapture::record(paths.rays[n], ray_t, depth);
+                if (scene.hit(paths.rays[n], ray_t, recs[n])) {
+                    queues[static_cast<size_t>(recs[n].mat->kind())].push_back(n);
+                } else {
+                    pixel_colors[paths.pixel[n]] += paths.throughput[n] * cam.background_;
+                    RT_STAT(paths_escaped++);
+                }
+            }
+
+            // Shade
+            next.clear();
+            scatter_queue<Lambertian>(queues[static_cast<size_t>(Material::Kind::Lambertian)], paths, recs, next);
+            scatter_queue<Metal>(queues[static_cast<size_t>(Material::Kind::Metal)], paths, recs, next);
+            scatter_queue<Dielectric>(queues[static_cast<size_t>(Material::Kind::Dielectric)], paths, recs, next);
+            scatter_queue<Isotropic>(queues[static_cast<size_t>(Material::Kind::Isotropic)], paths, recs, next);
 
-    // Wait 
-    std::clog << std::format("Running on {} threads...\n", pool.num_threads);
-    while (pool.has_next()) {
-        const float percentage = 100.0 * pool.progress();
-        std::clog << std::format("\r{:.2f}% ", percentage) << std::flush;
+            RT_STAT(paths_absorbed += queues[static_cast<size_t>(Material::Kind::DiffuseLight)].size());
+            for (const uint32_t n : queues[static_cast<size_t>(Material::Kind::DiffuseLight)]) {
+                const HitRecord &rec = recs[n];
+                pixel_colors[paths.pixel[n]] += paths.throughput[n] * static_cast<const DiffuseLight&>(*rec.mat).DiffuseLight::emitted(rec.u, rec.v, rec.p);
+            }
+
+            for (const uint32_t n : queues[static_cast<size_t>(Material::Kind::Other)]) {
+                const HitRecord &rec = recs[n];
+                pixel_colors[paths.pixel[n]] += paths.throughput[n] * rec.mat->emitted(rec.u, rec.v, rec.p);
+
+                Ray<real> scattered;
+                Color attenuation;
+                if (rec.mat->scatter(paths.rays[n], rec, attenuation, scattered)) {
+                    next.push(scattered, paths.throughput[n] * attenuation, paths.pixel[n]);
+                } else {
+                    RT_STAT(paths_absorbed++);
+                }
+            }
+
+            std::swap(paths, next);
+        }
+        RT_STAT(paths_depth_limited += paths.size());
+    }
+
+    for (size_t p = 0; p < num_pixels; p++) {
+        img.at(img.x + p / img.width, img.y + p % img.width) = pixel_colors[p] * rs.pixel_color_scale_;
+    }
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+void print_progress(const RenderProgress &progress) {
+    std::clog << std::format("\r{:.2f}% ", 100.0 * progress.fraction);
+    if (progress.fraction >= 1) {
+        std::clog << std::format("in {:.1f} s       \n", progress.seconds);
+    } else if (progress.eta_seconds) {
+        std::clog << std::format("ETA {:.1f} s       ", *progress.eta_seconds) << std::flush;
     }
-    std::clog << std::format("\r{:.2f}% \n", 100.0);
+}
+
+RenderStats render(Image &img, const Camera& cam, const Hittable& scene, const RenderSettings &rs, std::vector<TileCost> *tiles, const ProgressCallback &progress) {
+    return render(img, cam, std::vector<const Hittable*>{ &scene }, rs, tiles, progress);
+}
+
+RenderStats render(Image &img, const Camera& cam, const std::vector<const Hittable*> &replicas, const RenderSettings &rs, std::vector<TileCost> *tiles, const ProgressCallback &progress) {
+    RenderTaskGenerator gen(img, cam, replicas, rs);
+    const auto start = std::chrono::steady_clock::now();
+    const auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    {
+        ThreadPool pool(gen, rs.num_threads, rs.pin_threads_);
+
+        std::clog << std::format("Running on {} threads...\n", pool.num_threads);
+        pool.wait([&] {
+            const double fraction = pool.progress(), seconds = elapsed();
+            progress({ fraction, seconds, fraction > 0 ? std::optional(seconds * (1 - fraction) / fraction) : std::nullopt });
+        }, std::chrono::milliseconds(100));
+    }
+    progress({ 1, elapsed(), 0 });
+
+    if (tiles) {
+        *tiles = gen.tiles();
+    }
+
+    return gen.stats();
+}
+
+RenderStats render(Image &img, const Camera& cam, const Hittable& scene, const RenderSettings &rs, PersistentThreadPool &pool, std::vector<TileCost> *tiles) {
+    // The last chunks are split for the workers that actually run them.
+    RenderSettings pool_rs = rs;
+    pool_rs.num_threads = pool.num_threads;
+    RenderTaskGenerator gen(img, cam, scene, pool_rs);
+    pool.run(gen);
+
+    if (tiles) {
+        *tiles = gen.tiles();
+    }
+
+    return gen.stats();
+}
+
+RenderStats render_progressive(Image &img, const Camera& cam, const Hittable& scene, const RenderSettings &rs, uint32_t passes, const SnapshotCallback &snapshot) {
+    passes = std::clamp<uint32_t>(passes, 1, rs.samples_per_pixel_);
+    RenderSettings pass_rs = rs;
+    pass_rs.set_samples_per_pixel(rs.samples_per_pixel_ / passes);
+
+    PersistentThreadPool pool(rs.num_threads, rs.pin_threads_);
+    std::clog << std::format("Running {} passes of {} samples on {} threads...\n", passes, pass_rs.samples_per_pixel_, pool.num_threads);
+
+    RenderStats stats;
+    Image pass_img(img.width_, img.height_);
+    std::vector<std::vector<Color>> sum(img.height_, std::vector<Color>(img.width_));
+    double seconds = 0;
+    for (uint32_t pass = 0; pass < passes; pass++) {
+        pass_rs.seed_ = mix_seed(rs.seed_, pass);
+        const auto start = std::chrono::steady_clock::now();
+        const RenderStats pass_stats = render(pass_img, cam, scene, pass_rs, pool);
+
+        const real scale = real(1) / (pass + 1);
+        for (int32_t i = 0; i < img.height_; i++) {
+            for (int32_t j = 0; j < img.width_; j++) {
+                sum[i][j] += pass_img.pixels_[i][j];
+                img.pixels_[i][j] = sum[i][j] * scale;
+            }
+        }
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        stats.rays += pass_stats.rays;
+        stats.samples += pass_stats.samples;
+        stats.traversal += pass_stats.traversal;
+        std::clog << std::format("\rPass {}/{} ", pass + 1, passes) << std::flush;
+        snapshot(img, (pass + 1) * pass_rs.samples_per_pixel_, seconds);
+    }
+    std::clog << '\n';
+
+    return stats;
+}
+
+void fit_chunks(RenderSettings &rs, const Image &img) {
+    // The generator splits the last chunks for balance, so a few per thread
+    // are enough.
+    constexpr int32_t CHUNKS_PER_THREAD = 4;
+    // Multiples of the camera ray packets, so only edge chunks trace partial
+    // ones.
+    constexpr int32_t WIDTH_STEP = 4, HEIGHT_STEP = RenderTaskGenerator::BAND_HEIGHT;
+
+    const auto round_to = [](double size, int32_t step, int32_t max) {
+        return std::clamp(static_cast<int32_t>(std::lround(size / step)) * step, step, std::max(max, step));
+    };
+
+    const double side = std::sqrt(static_cast<double>(img.width_) * img.height_ / (std::max(rs.num_threads, 1u) * CHUNKS_PER_THREAD));
+    if (rs.chunk_width_ <= 0) {
+        rs.chunk_width_ = round_to(side, WIDTH_STEP, img.width_);
+    }
+
+    if (rs.chunk_height_ <= 0) {
+        rs.chunk_height_ = round_to(side, HEIGHT_STEP, img.height_);
+    }
+
+    rs.chunk_width_ = std::min(rs.chunk_width_, img.width_);
+    rs.chunk_height_ = std::min(rs.chunk_height_, img.height_);
 }
 
 std::optional<std::function<void()>> RenderTaskGenerator::next() {
     if (has_next()) {
-        ImageChunk chunk = ImageChunk(current_chunk_ / chunks_per_row_ * rs_.chunk_height_, (current_chunk_ % chunks_per_row_) * rs_.chunk_width_, rs_.chunk_width_, rs_.chunk_height_, img_.pixels_);
-        current_chunk_++;
-        return [this, chunk = std::move(chunk)] { render_chunk(cam_, scene_, rs_, chunk); };
+        Piece piece;
+        if (!pieces_.empty()) {
+            piece = pieces_.front();
+            pieces_.pop_front();
+        } else {
+            // The worker's own range first, then the back of the range with
+            // the most chunks left, away from where its own workers are.
+            ChunkRange *range = &ranges_[Numa::current_node() % ranges_.size()];
+            int32_t index;
+            if (range->next < range->end) {
+                index = range->next++;
+            } else {
+                range = &*std::max_element(ranges_.begin(), ranges_.end(), [](const ChunkRange &a, const ChunkRange &b) { return a.end - a.next < b.end - b.next; });
+                index = --range->end;
+            }
+            remaining_--;
+            piece = { index, 0, chunk(index).height, 0, num_blocks_ };
+        }
+
+        // Once there are fewer pieces left than workers, halve this one
+        // until there are enough: by rows down to a single band, then by
+        // sample blocks. The last expensive chunks are then shared by every
+        // worker instead of keeping a few busy while the rest idle. Wavefront
+        // chunks trace all their paths from one random stream, so they are
+        // never split.
+        while (rs_.integrator_ != Integrator::Wavefront && remaining_ + pieces_.size() + 1 < rs_.num_threads) {
+            if (piece.end_row - piece.first_row > BAND_HEIGHT) {
+                const int32_t bands = (piece.end_row - piece.first_row + BAND_HEIGHT - 1) / BAND_HEIGHT;
+                const int32_t middle = piece.first_row + bands / 2 * BAND_HEIGHT;
+                pieces_.push_front({ piece.chunk, middle, piece.end_row, piece.first_block, piece.end_block });
+                piece.end_row = middle;
+            } else if (piece.end_block - piece.first_block > 1) {
+                const int32_t middle = (piece.first_block + piece.end_block) / 2;
+                pieces_.push_front({ piece.chunk, piece.first_row, piece.end_row, middle, piece.end_block });
+                piece.end_block = middle;
+            } else {
+                break;
+            }
+        }
+
+        return [this, piece] {
+            const ImageChunk bounds = chunk(piece.chunk);
+            RayCapture::Chunk capture({ piece.chunk, piece.first_row, piece.first_block });
+            const auto start = std::chrono::steady_clock::now();
+            const uint64_t rays = rays_traced;
+#ifdef RT_STATS
+            TraversalStats::local() = {};
+#endif
+            const Hittable &scene = *replicas_[Numa::current_node() % replicas_.size()];
+            if (rs_.integrator_ == Integrator::Wavefront) {
+                seed_random(mix_seed(rs_.seed_, piece.chunk));
+                render_chunk(cam_, scene, rs_, bounds);
+            } else {
+                for (int32_t row = piece.first_row; row < piece.end_row; row += BAND_HEIGHT) {
+                    render_band(scene, piece, bounds, row);
+                }
+            }
+            const auto end = std::chrono::steady_clock::now();
+
+            // Pieces of one chunk add up to its cost.
+            const double seconds = std::chrono::duration<double>(end - start).count();
+            const uint64_t piece_rays = rays_traced - rays;
+            {
+                std::lock_guard lock(tiles_mutex_);
+                TileCost &tile = tiles_[piece.chunk];
+                tile = { bounds.x, bounds.y, bounds.width, bounds.height, tile.seconds + seconds, tile.rays + piece_rays };
+            }
+            rays_ += piece_rays;
+            rows_done_ += (piece.end_row - piece.first_row) * (piece.end_block - piece.first_block);
+            if (Trace::enabled()) {
+                Trace::complete("tile", "render", start, end, std::format("\"row\": {}, \"column\": {}, \"rows\": {}, \"first_block\": {}, \"blocks\": {}, \"rays\": {}",
+                    bounds.x + piece.first_row, bounds.y, piece.end_row - piece.first_row, piece.first_block, piece.end_block - piece.first_block, piece_rays));
+            }
+#ifdef RT_STATS
+            std::lock_guard lock(traversal_mutex_);
+            traversal_ += TraversalStats::local();
+#endif
+        };
     }
     return std::nullopt;
 }
+
+// Renders the sample blocks of `piece` for the band starting at `row` of its
+// chunk, `bounds`.
+void RenderTaskGenerator::render_band(const Hittable &scene, const Piece &piece, const ImageChunk &bounds, int32_t row) {
+    const int32_t x = bounds.x, y = bounds.y, width = bounds.width;
+    const int32_t height = std::min(BAND_HEIGHT, piece.end_row - row);
+    const uint64_t seed = mix_seed(mix_seed(rs_.seed_, piece.chunk), row / BAND_HEIGHT);
+    if (num_blocks_ == 1) {
+        seed_random(seed);
+        render_chunk(cam_, scene, rs_, ImageChunk(x + row, y, width, height, img_.pixels_));
+        return;
+    }
+
+    const auto block_samples = [&](int32_t block) { return std::min(SAMPLE_BLOCK, rs_.samples_per_pixel_ - block * SAMPLE_BLOCK); };
+    for (int32_t block = piece.first_block; block < piece.end_block; block++) {
+        RenderSettings block_rs = rs_;
+        block_rs.set_samples_per_pixel(block_samples(block));
+        std::vector<std::vector<Color>> pixels(height, std::vector<Color>(width));
+        seed_random(mix_seed(seed, block));
+        render_chunk(cam_, scene, block_rs, ImageChunk(x + row, y, width, height, pixels, x + row, y));
+
+        const int64_t key = static_cast<int64_t>(piece.chunk) << 32 | row;
+        std::lock_guard lock(bands_mutex_);
+        BandBlocks &band = bands_[key];
+        band.blocks.resize(num_blocks_);
+        band.blocks[block] = std::move(pixels);
+        if (++band.done < num_blocks_) continue;
+
+        // Weighted by samples and summed in block order, so the result
+        // doesn't depend on which block finished first.
+        for (int32_t i = 0; i < height; i++) {
+            for (int32_t j = 0; j < width; j++) {
+                Color sum;
+                for (int32_t b = 0; b < num_blocks_; b++) {
+                    sum += band.blocks[b][i][j] * (block_samples(b) * rs_.pixel_color_scale_);
+                }
+                img_.pixels_[x + row + i][y + j] = sum;
+            }
+        }
+        bands_.erase(key);
+    }
+}
@@ -3,12 +3,27 @@
 #include "thread_pool.hpp"
 #include "image.hpp"
 #include "ray.hpp"
-#include "hittable_list.hpp"
+#include "hittable.hpp"
 #include "camera.hpp"
+#include "cpu_count.hpp"
+#include "numa.hpp"
+#include "stats.hpp"
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <map>
+#include <functional>
+#include <mutex>
 #include <optional>
+#include <vector>
 #include <cassert>
 
+// How radiance is estimated along each path.
+//  - Recursive: `ray_color` follows one path at a time, depth first.
+//  - Wavefront: each chunk advances batches of paths one bounce at a time
+//    and shades the hits of each material type together.
+enum class Integrator { Recursive, Wavefront };
+
 class RenderSettings {
 public:
     RenderSettings(int32_t samples_per_pixel, int32_t max_depth) : samples_per_pixel_(samples_per_pixel), pixel_color_scale_(1.0 / samples_per_pixel_), max_depth_(max_depth) {}
@@ -20,37 +35,166 @@ public:
     }
 
     int32_t samples_per_pixel_ = 100;
-    double pixel_color_scale_ = 1.0 / 100.0;
+    real pixel_color_scale_ = 1.0 / 100.0;
     int32_t max_depth_ = 50;
-    uint32_t num_threads = std::thread::hardware_concurrency();
+    uint32_t num_threads = CpuCount::get().count;
     int32_t chunk_width_ = 0, chunk_height_ = 0;
+    bool packets_ = true;   // Trace camera rays in packets when the scene is compiled.
+    Integrator integrator_ = Integrator::Recursive;
+    // Band `b` of chunk `i` draws its samples from seed
+    // mix_seed(mix_seed(seed_, i), b), the whole chunk from mix_seed(seed_, i)
+    // with the wavefront integrator.
+    uint64_t seed_ = 0;
+    // Pin workers to CPUs spread over the NUMA nodes, see Numa::pin_worker.
+    // The chunks are split into one range per node, which its workers render
+    // before helping the others.
+    bool pin_threads_ = false;
 
 private:
     friend struct YAML::convert<RenderSettings>;
 };
 
-void render(Image &img, const Camera& cam, const HittableList& scene, const RenderSettings &rs);
+// Work done by one render.
+struct RenderStats {
+    uint64_t rays = 0;      // Rays intersected with the scene, all bounces.
+    uint64_t samples = 0;   // Camera samples, pixels times samples per pixel.
+    TraversalStats traversal;   // All zero unless built with -DRT_STATS.
+};
+
+// Wall time and rays of one chunk. `x` is its first row and `y` its first
+// column, as in ImageChunk.
+struct TileCost {
+    int32_t x = 0, y = 0, width = 0, height = 0;
+    double seconds = 0;
+    uint64_t rays = 0;
+};
+
+// How far a render has got, as passed to a ProgressCallback.
+struct RenderProgress {
+    double fraction;    // Of the work done, from 0 to 1.
+    double seconds;     // Since the render started.
+    // Time left at the rate so far; none until some work is done.
+    std::optional<double> eta_seconds;
+};
+
+// Called periodically while `render` runs, and once more with a fraction of 1
+// as soon as it's done.
+using ProgressCallback = std::function<void(const RenderProgress &)>;
+
+// Prints a status line with the percentage and ETA to std::clog.
+void print_progress(const RenderProgress &progress);
+
+// When `tiles` is set, it receives the cost of every chunk in chunk order.
+RenderStats render(Image &img, const Camera& cam, const Hittable& scene, const RenderSettings &rs, std::vector<TileCost> *tiles = nullptr, const ProgressCallback &progress = print_progress);
+
+// Renders with one copy of the scene per NUMA node, as made by
+// Numa::on_each_node; workers trace the copy of the node they are pinned to.
+RenderStats render(Image &img, const Camera& cam, const std::vector<const Hittable*> &replicas, const RenderSettings &rs, std::vector<TileCost> *tiles = nullptr, const ProgressCallback &progress = print_progress);
+
+// Renders on the workers of `pool`, whose number replaces `rs.num_threads`
+// (e.g. in how far the last chunks are split).
+RenderStats render(Image &img, const Camera& cam, const Hittable& scene, const RenderSettings &rs, PersistentThreadPool &pool, std::vector<TileCost> *tiles = nullptr);
+
+// Called after each pass of `render_progressive` with the average of the
+// passes so far, its samples per pixel and the render time so far in seconds.
+using SnapshotCallback = std::function<void(const Image &average, uint32_t samples_per_pixel, double seconds)>;
+
+// Renders `passes` independently seeded passes of `rs.samples_per_pixel_ /
+// passes` samples each, leaving their average in `img`.
+RenderStats render_progressive(Image &img, const Camera& cam, const Hittable& scene, const RenderSettings &rs, uint32_t passes, const SnapshotCallback &snapshot);
+
+// Picks a chunk size for `img` when none is set: about square, giving a
+// fixed number of chunks per thread at any resolution. Sizes need not divide
+// the image; the last row and column of chunks are clipped.
+void fit_chunks(RenderSettings &rs, const Image &img);
 
 class RenderTaskGenerator : public TaskGenerator {
 public:
-    RenderTaskGenerator(Image& img, const Camera& cam, const HittableList& scene, const RenderSettings &rs) :
-     img_(img), cam_(cam), scene_(scene), rs_(rs), num_chunks_(img.width_ * img.height_ / (rs.chunk_width_ * rs.chunk_height_)), chunks_per_row_(img.width_ / rs.chunk_width_) {
-         assert(img.width_ % rs_.chunk_width_ == 0 && "Chunk width must be a factor of the image width.");
-         assert(img.height_ % rs_.chunk_height_ == 0 && "Chunk height must be a factor of the image height.");
+    // Splits the chunks into `num_ranges` contiguous ranges; workers of NUMA
+    // node `n` take chunks from range `n` first.
+    RenderTaskGenerator(Image& img, const Camera& cam, std::vector<const Hittable*> replicas, const RenderSettings &rs, int32_t num_ranges) :
+     img_(img), cam_(cam), replicas_(std::move(replicas)), rs_(rs), chunks_per_row_((img.width_ + rs.chunk_width_ - 1) / rs.chunk_width_),
+     num_chunks_(chunks_per_row_ * ((img.height_ + rs.chunk_height_ - 1) / rs.chunk_height_)),
+     num_blocks_(rs.integrator_ == Integrator::Wavefront ? 1 : (rs.samples_per_pixel_ + SAMPLE_BLOCK - 1) / SAMPLE_BLOCK), remaining_(num_chunks_), tiles_(num_chunks_) {
+         for (int32_t n = 0; n < num_ranges; n++) {
+             ranges_.push_back({ num_chunks_ * n / num_ranges, num_chunks_ * (n + 1) / num_ranges });
+         }
      }
 
+    // One range per NUMA node when `rs` pins workers, one in all otherwise.
+    RenderTaskGenerator(Image& img, const Camera& cam, std::vector<const Hittable*> replicas, const RenderSettings &rs) :
+     RenderTaskGenerator(img, cam, std::move(replicas), rs, rs.pin_threads_ ? Numa::num_nodes() : 1) {}
+
+    RenderTaskGenerator(Image& img, const Camera& cam, const Hittable& scene, const RenderSettings &rs) : RenderTaskGenerator(img, cam, std::vector<const Hittable*>{ &scene }, rs) {}
+
     std::optional<std::function<void()>> next() override;
 
-    bool has_next() const override { return current_chunk_ < num_chunks_; }
+    bool has_next() const override { return remaining_ > 0 || !pieces_.empty(); }
+
+    // Chunks may be split, so this counts rendered rows (of each sample
+    // block) instead of tasks.
+    double progress(size_t) const override { return static_cast<double>(rows_done_) / (static_cast<int64_t>(chunks_per_row_) * img_.height_ * num_blocks_); }
+
+    // Rows that share one random stream. Chunks are only split between
+    // bands, so the image doesn't depend on how they were split; it matches
+    // the packet height so packets never straddle two bands.
+    static constexpr int32_t BAND_HEIGHT = 2;
 
-    double progress(size_t count) const override { return static_cast<double>(count) / num_chunks_; }
+    // Samples per pixel that share one random stream. With more, every band
+    // is rendered in blocks of this many samples into private buffers, which
+    // can run on different workers (e.g. a thumbnail at 10k spp, with fewer
+    // bands than workers) and are summed in block order once all are done.
+    static constexpr int32_t SAMPLE_BLOCK = 256;
+
+    // Filled in as chunks finish; complete once the pool is done.
+    const std::vector<TileCost>& tiles() const { return tiles_; }
+
+    RenderStats stats() const { return { rays_, static_cast<uint64_t>(img_.width_) * img_.height_ * rs_.samples_per_pixel_, traversal_ }; }
 
 private:
     Image& img_;
     const Camera& cam_;
-    const HittableList& scene_;
+    // Chunks [next, end) not handed out yet.
+    struct ChunkRange {
+        int32_t next, end;
+    };
+
+    // Rows [first_row, end_row) of a chunk, counted from its top, and
+    // sample blocks [first_block, end_block) of them.
+    struct Piece {
+        int32_t chunk, first_row, end_row, first_block, end_block;
+    };
+
+    // Finished sample blocks of one band, until all are in.
+    struct BandBlocks {
+        std::vector<std::vector<std::vector<Color>>> blocks;
+        int32_t done = 0;
+    };
+
+    // Chunk `index` of the image. Chunks on the right and bottom edges are
+    // clipped to it.
+    ImageChunk chunk(int32_t index) const {
+        const int32_t x = index / chunks_per_row_ * rs_.chunk_height_;
+        const int32_t y = index % chunks_per_row_ * rs_.chunk_width_;
+        return ImageChunk(x, y, std::min(rs_.chunk_width_, img_.width_ - y), std::min(rs_.chunk_height_, img_.height_ - x), img_.pixels_);
+    }
+
+    void render_band(const Hittable &scene, const Piece &piece, const ImageChunk &bounds, int32_t row);
+
+    std::vector<const Hittable*> replicas_;
     const RenderSettings& rs_;
-    int32_t current_chunk_ = 0;
-    int32_t num_chunks_;
     int32_t chunks_per_row_;
+    int32_t num_chunks_;
+    int32_t num_blocks_;    // Sample blocks per band.
+    int32_t remaining_;
+    std::vector<ChunkRange> ranges_;    // One per NUMA node when pinned.
+    std::deque<Piece> pieces_;          // Split off chunks, largest first.
+    std::atomic<int64_t> rows_done_ = 0;
+    std::mutex bands_mutex_;
+    std::map<int64_t, BandBlocks> bands_;   // By chunk << 32 | band row.
+    std::mutex tiles_mutex_;
+    std::atomic<uint64_t> rays_ = 0;
+    std::vector<TileCost> tiles_;
+    std::mutex traversal_mutex_;
+    TraversalStats traversal_;
 };
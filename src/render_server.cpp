@@ -0,0 +1,246 @@
+#include "render_server.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "image.hpp"
+#include "scene.hpp"
+#include "serialization.hpp"
+
+namespace YAML {
+template<>
+struct convert<RenderJob> {
+    static Node encode(const RenderJob &rhs) {
+        Node node;
+
+        node["scene"] = rhs.scene;
+        node["width"] = rhs.width;
+        node["height"] = rhs.height;
+        if (rhs.camera) {
+            node["camera"] = *rhs.camera;
+        }
+        node["render"] = rhs.rs;
+        node["output"] = rhs.output;
+
+        return node;
+    }
+
+    static bool decode(const Node &node, RenderJob &rhs) {
+        if (!node.IsMap() || !node["scene"] || !node["width"] || !node["height"] || !node["output"]) return false;
+
+        rhs.scene = node["scene"].as<std::string>();
+        rhs.width = node["width"].as<int32_t>();
+        rhs.height = node["height"].as<int32_t>();
+        rhs.output = node["output"].as<std::string>();
+
+        if (node["camera"].IsDefined()) {
+            rhs.camera = node["camera"].as<CameraBuilder>();
+        }
+
+        if (node["render"].IsDefined()) {
+            rhs.rs = node["render"].as<RenderSettings>();
+        }
+
+        return true;
+    }
+};
+}
+
+static sockaddr_un socket_address(const std::string &socket_path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error(std::format("Socket path too long: {}.", socket_path));
+    }
+    std::strcpy(addr.sun_path, socket_path.c_str());
+
+    return addr;
+}
+
+// How long the server waits on a client that has connected but not finished
+// sending its job.
+constexpr timeval JOB_READ_TIMEOUT = { .tv_sec = 10, .tv_usec = 0 };
+
+// Reads until the other side shuts down its write side. Throws
+// `std::runtime_error` if the read fails or times out.
+static std::string read_all(int fd) {
+    std::string data;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                throw std::runtime_error(std::format("Timed out after {} s waiting for the job.", JOB_READ_TIMEOUT.tv_sec));
+            }
+            throw std::runtime_error(std::format("Failed to read the job: {}.", std::strerror(errno)));
+        }
+        data.append(buffer, n);
+    }
+
+    return data;
+}
+
+static void write_all(int fd, const std::string &data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        const ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n <= 0) return;
+        written += n;
+    }
+}
+
+// Removes the socket a previous server left at `socket_path`. Throws
+// `std::runtime_error` if something else is there, or a server still answers
+// on it.
+static void remove_stale_socket(const std::string &socket_path, const sockaddr_un &addr) {
+    struct stat st;
+    if (::lstat(socket_path.c_str(), &st) != 0) {
+        if (errno == ENOENT) return;
+        throw std::runtime_error(std::format("Failed to check {}: {}.", socket_path, std::strerror(errno)));
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        throw std::runtime_error(std::format("Not a socket, refusing to replace it: {}.", socket_path));
+    }
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    const bool live = fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+    if (fd >= 0) ::close(fd);
+    if (live) {
+        throw std::runtime_error(std::format("A server is already listening on {}.", socket_path));
+    }
+
+    ::unlink(socket_path.c_str());
+}
+
+void RenderServer::serve(const std::string &socket_path) {
+    // A client hanging up before its reply must not kill the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const sockaddr_un addr = socket_address(socket_path);
+    remove_stale_socket(socket_path, addr);
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || ::bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listener, 16) != 0) {
+        throw std::runtime_error(std::format("Failed to listen on {}: {}.", socket_path, std::strerror(errno)));
+    }
+
+    std::clog << std::format("Listening on {} with {} threads...\n", socket_path, pool_.num_threads);
+    while (true) {
+        const int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+
+        // A client that never shuts down its write side must not stall the
+        // jobs queued behind it.
+        ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &JOB_READ_TIMEOUT, sizeof(JOB_READ_TIMEOUT));
+
+        std::string reply;
+        try {
+            reply = run(YAML::Load(read_all(client)).as<RenderJob>());
+        } catch (const std::exception &err) {
+            reply = std::format("error: {}\n", err.what());
+        }
+
+        std::clog << reply;
+        write_all(client, reply);
+        ::close(client);
+    }
+}
+
+std::string RenderServer::run(const RenderJob &job) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+
+    // A bad job must fail on its own, not take the server down with it.
+    if (job.width <= 0 || job.height <= 0) {
+        throw std::runtime_error(std::format("Invalid image size: {}x{}.", job.width, job.height));
+    }
+    if (job.rs.samples_per_pixel_ <= 0 || job.rs.max_depth_ < 0) {
+        throw std::runtime_error(std::format("Invalid render settings: {} samples per pixel, max depth {}.", job.rs.samples_per_pixel_, job.rs.max_depth_));
+    }
+    if (job.rs.chunk_width_ < 0 || job.rs.chunk_height_ < 0) {
+        throw std::runtime_error(std::format("Invalid chunk size: {}x{}.", job.rs.chunk_width_, job.rs.chunk_height_));
+    }
+
+    bool cached = false;
+    const SceneFile::Loaded &loaded = scene(job.scene, cached);
+    const auto loaded_at = Clock::now();
+
+    Image img(job.width, job.height);
+    RenderSettings rs = job.rs;
+    rs.num_threads = pool_.num_threads;
+    fit_chunks(rs, img);
+
+    const CameraBuilder &cb = job.camera ? *job.camera : loaded.cb;
+    render(img, cb.build(img), *loaded.scene, rs, pool_);
+    const auto rendered_at = Clock::now();
+
+    std::ofstream file(job.output);
+    if (!(file << img)) {
+        throw std::runtime_error(std::format("Failed to write file: {}.", job.output));
+    }
+
+    const auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    return std::format("ok: {} scene {} in {:.1f} ms, rendered in {:.1f} ms\n", job.output, cached ? "cached" : "loaded", ms(start, loaded_at), ms(loaded_at, rendered_at));
+}
+
+const SceneFile::Loaded& RenderServer::scene(const std::string &file_name, bool &cached) {
+    const auto mtime = std::filesystem::last_write_time(file_name);
+
+    const auto it = index_.find(file_name);
+    if (it != index_.end()) {
+        if (it->second->mtime == mtime) {
+            scenes_.splice(scenes_.begin(), scenes_, it->second);
+            cached = true;
+            return scenes_.front().loaded;
+        }
+
+        // Edited since it was loaded.
+        scenes_.erase(it->second);
+        index_.erase(it);
+    }
+
+    SceneFile::Loaded loaded;
+    if (SceneFile::is_scene_file(file_name)) {
+        loaded = SceneFile::load(file_name);
+    } else {
+        Scene scene = LoadScene(file_name);
+        loaded = { scene.compile(), scene.cb_ };
+    }
+
+    scenes_.push_front({file_name, mtime, std::move(loaded)});
+    index_[file_name] = scenes_.begin();
+
+    while (scenes_.size() > max_scenes_) {
+        index_.erase(scenes_.back().file_name);
+        scenes_.pop_back();
+    }
+
+    cached = false;
+    return scenes_.front().loaded;
+}
+
+std::string submit_job(const std::string &socket_path, const RenderJob &job) {
+    const sockaddr_un addr = socket_address(socket_path);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        const std::string error = std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error(std::format("Failed to connect to {}: {}.", socket_path, error));
+    }
+
+    YAML::Emitter em;
+    em << YAML::convert<RenderJob>::encode(job);
+    write_all(fd, em.c_str());
+    ::shutdown(fd, SHUT_WR);
+
+    const std::string reply = read_all(fd);
+    ::close(fd);
+
+    return reply;
+}
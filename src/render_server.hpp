@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "camera.hpp"
+#include "render.hpp"
+#include "scene_file.hpp"
+#include "thread_pool.hpp"
+
+// One render request: the scene to load (YAML or a compiled scene file), an
+// optional camera replacing the scene's, the settings and the PPM file the
+// image is written to. Paths are resolved by the server, so clients send
+// absolute ones.
+struct RenderJob {
+    std::string scene;
+    int32_t width = 0, height = 0;
+    std::optional<CameraBuilder> camera;
+    RenderSettings rs;
+    std::string output;
+};
+
+// Renders jobs received on a Unix domain socket, one at a time. Decoded
+// scenes (with their textures and BVH) stay loaded in an LRU cache and the
+// worker threads are kept between jobs, so a job that only changes the camera
+// starts rendering right away.
+//
+// Wire format: a client connects, writes the job as a YAML document, shuts
+// down its write side and reads a single line back, either `ok: ...` or
+// `error: ...`. A client that doesn't send its whole job within 10 s gets an
+// error back.
+class RenderServer {
+public:
+    RenderServer(size_t num_threads, size_t max_scenes) : pool_(num_threads), max_scenes_(std::max<size_t>(max_scenes, 1)) {}
+
+    // Accepts jobs on `socket_path` until the process is stopped. A socket
+    // left there by a server that has exited is replaced. Throws
+    // `std::runtime_error`, leaving the path alone, if it holds anything
+    // else or a server still answers on it.
+    void serve(const std::string &socket_path);
+
+    // Renders `job` and returns the reply line.
+    std::string run(const RenderJob &job);
+
+private:
+    struct CachedScene {
+        std::string file_name;
+        std::filesystem::file_time_type mtime;
+        SceneFile::Loaded loaded;
+    };
+
+    PersistentThreadPool pool_;
+    size_t max_scenes_;
+    std::list<CachedScene> scenes_;     // Most recently used first.
+    std::unordered_map<std::string, std::list<CachedScene>::iterator> index_;
+
+    const SceneFile::Loaded& scene(const std::string &file_name, bool &cached);
+};
+
+// Sends `job` to the server listening on `socket_path` and returns its reply.
+// Throws `std::runtime_error` if the server can't be reached.
+std::string submit_job(const std::string &socket_path, const RenderJob &job);
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "compiled_scene.hpp"
+#include "ray_capture.hpp"
+#include "scene.hpp"
+#include "scene_file.hpp"
+#include "serialization.hpp"
+#include "argparse/argparse.hpp"
+
+// Closest hit of every ray, or `infinity` for a miss.
+using HitTimes = std::vector<real>;
+
+struct ReplayKernel {
+    const char *name;
+    std::function<void(const std::vector<CapturedRay>&, HitTimes&)> trace;
+};
+
+static void trace_each(const Hittable &scene, const std::vector<CapturedRay> &rays, HitTimes &t) {
+    HitRecord rec;
+    for (size_t i = 0; i < rays.size(); i++) {
+        t[i] = scene.hit(rays[i].ray(), rays[i].interval(), rec) ? rec.t : infinity;
+    }
+}
+
+// Feeds consecutive rays with the same interval to `hit_packet`, as the
+// renderer does for the camera rays of a pixel block.
+static void trace_packets(const CompiledScene &scene, const std::vector<CapturedRay> &rays, HitTimes &t) {
+    Ray<real> packet[CompiledScene::PACKET_SIZE];
+    HitRecord recs[CompiledScene::PACKET_SIZE];
+    bool hits[CompiledScene::PACKET_SIZE];
+
+    for (size_t first = 0; first < rays.size();) {
+        size_t count = 0;
+        while (count < CompiledScene::PACKET_SIZE && first + count < rays.size()
+            && rays[first + count].t_min == rays[first].t_min && rays[first + count].t_max == rays[first].t_max) {
+            packet[count] = rays[first + count].ray();
+            count++;
+        }
+
+        scene.hit_packet(packet, count, rays[first].interval(), recs, hits);
+        for (size_t n = 0; n < count; n++) {
+            t[first + n] = hits[n] ? recs[n].t : infinity;
+        }
+        first += count;
+    }
+}
+
+// Traces rays recorded with `main --capture-rays` through each traversal
+// kernel, without shading, and reports its throughput and whether its hits
+// agree with the first kernel's. Add candidate kernels to the table below.
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser program("replay");
+
+    program.add_argument("scene")
+        .help("the scene the rays were captured in, YAML or compiled.");
+
+    program.add_argument("rays")
+        .help("ray file written by `main --capture-rays`.");
+
+    program.add_argument("-d", "--depth")
+        .help("only replay rays of this bounce depth, 0 for camera rays.")
+        .scan<'i', uint32_t>();
+
+    program.add_argument("-r", "--runs")
+        .help("passes per kernel; the fastest is reported.")
+        .default_value(uint32_t(3))
+        .scan<'i', uint32_t>();
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<CapturedRay> rays;
+    std::shared_ptr<CompiledScene> compiled;
+    std::shared_ptr<Hittable> bvh;
+    try {
+        rays = RayCapture::read(program.get("rays"));
+
+        const std::string scene_file_name = program.get("scene");
+        if (SceneFile::is_scene_file(scene_file_name)) {
+            compiled = SceneFile::load(scene_file_name).scene;
+        } else {
+            Scene scene = LoadScene(scene_file_name);
+            compiled = scene.compile();
+            bvh = scene.bvh();
+        }
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (auto depth = program.present<uint32_t>("depth")) {
+        std::erase_if(rays, [&](const CapturedRay &ray) { return ray.depth != *depth; });
+    }
+    std::clog << std::format("Replaying {} rays...\n", rays.size());
+
+    std::vector<ReplayKernel> kernels = {
+        { "compiled", [&](const auto &rays, auto &t) { trace_each(*compiled, rays, t); } },
+        { "compiled-packet", [&](const auto &rays, auto &t) { trace_packets(*compiled, rays, t); } },
+    };
+    if (bvh) {
+        kernels.push_back({ "bvh", [&](const auto &rays, auto &t) { trace_each(*bvh, rays, t); } });
+    }
+
+    // Hits inside a constant medium are random, so they may disagree.
+    HitTimes reference;
+    std::cout << std::format("{:<20} {:>10} {:>12} {:>12} {:>12}\n", "kernel", "seconds", "Mrays/s", "hits", "mismatches");
+    for (const auto &kernel : kernels) {
+        HitTimes t(rays.size());
+        double best = INFINITY;
+        for (uint32_t run = 0; run < std::max<uint32_t>(program.get<uint32_t>("runs"), 1); run++) {
+            seed_random(0);
+            const auto start = std::chrono::steady_clock::now();
+            kernel.trace(rays, t);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        if (reference.empty()) {
+            reference = t;
+        }
+
+        size_t hits = 0, mismatches = 0;
+        for (size_t i = 0; i < t.size(); i++) {
+            hits += t[i] != infinity;
+            mismatches += t[i] != reference[i] && !(std::fabs(t[i] - reference[i]) <= 1e-6 * std::fabs(reference[i]));
+        }
+
+        std::cout << std::format("{:<20} {:>10.4f} {:>12.3f} {:>12} {:>12}\n", kernel.name, best, rays.size() / best / 1e6, hits, mismatches);
+    }
+
+    return EXIT_SUCCESS;
+}
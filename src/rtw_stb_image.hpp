@@ -10,11 +10,14 @@
 #include <iostream>
 #include <string>
 
+#include "trace.hpp"
+
 class RTWImage {
 public:
     RTWImage() {}
     RTWImage(const char *image_file_name) {
         const auto file_name = std::string(image_file_name);
+        TraceScope trace("decode texture", "load", std::format("\"file\": \"{}\"", Trace::escape(file_name)));
         const auto image_dir = getenv("RTW_IMAGES");
 
         if (image_dir && load(std::string(image_dir) + "/" + image_file_name)) return;
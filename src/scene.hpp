@@ -1,29 +1,79 @@
 #pragma once
 #include <memory>
+#include <unordered_map>
+#include "arena.hpp"
 #include "camera.hpp"
+#include "compiled_scene.hpp"
 #include "hittable.hpp"
 #include "hittable_list.hpp"
+#include "instance.hpp"
 #include "material.hpp"
 #include "bvh.hpp"
 
 class Scene {
 public:
-    Scene() {}
+    Scene() : arena_(std::make_shared<Arena>()) {}
 
     void add_texture(std::shared_ptr<Texture> tex) { textures_.push_back(tex); }
     void add_material(std::shared_ptr<Material> mat) { materials_.push_back(mat); }
     void add_ref(std::shared_ptr<Hittable> ref) { refs_.push_back(ref); }
     void add_object(std::shared_ptr<Hittable> obj) { objs_.add(obj); }
 
-    std::shared_ptr<BVHNode> bvh() { return std::make_shared<BVHNode>(objs_); }
- 
+    // Places a transformed copy of `ref`. Every instance of the same ref
+    // shares one bottom-level BVH.
+    void add_instance(std::shared_ptr<Hittable> ref, const Transform &xf) {
+        ArenaScope scope(arena_);
+        instances_.push_back(make_arena_shared<Instance>(blas(ref), xf));
+    }
+
+    // Top-level BVH over the scene objects and the instances.
+    std::shared_ptr<BVHNode> bvh() {
+        ArenaScope scope(arena_);
+        HittableList top = objs_;
+        for (const auto &instance : instances_) {
+            top.add(instance);
+        }
+
+        return make_arena_shared<BVHNode>(top);
+    }
+
+    // Flattened render-time form of the objects and instances.
+    std::shared_ptr<CompiledScene> compile() const {
+        std::vector<std::shared_ptr<Hittable>> top = objs_.objs;
+        top.insert(top.end(), instances_.begin(), instances_.end());
+
+        return std::make_shared<CompiledScene>(top);
+    }
+
+    // Bottom-level acceleration structure for `ref`, built once per ref.
+    std::shared_ptr<Hittable> blas(std::shared_ptr<Hittable> ref) {
+        ArenaScope scope(arena_);
+        auto it = blas_.find(ref);
+        if (it != blas_.end()) {
+            return it->second;
+        }
+
+        std::shared_ptr<Hittable> accel = ref;
+        if (const auto list = std::dynamic_pointer_cast<HittableList>(ref); list && !list->objs.empty()) {
+            accel = make_arena_shared<BVHNode>(*list);
+        }
+
+        blas_[ref] = accel;
+        return accel;
+    }
+
     std::vector<std::shared_ptr<Texture>> textures_;
     std::vector<std::shared_ptr<Material>> materials_;
     std::vector<std::shared_ptr<Hittable>> refs_;
     HittableList objs_;
+    std::vector<std::shared_ptr<Instance>> instances_;
+    std::unordered_map<std::shared_ptr<Hittable>, std::shared_ptr<Hittable>> blas_;
+
+    // Backing store for the decoded scene graph and its BVH nodes. Shared by
+    // copies of the scene; released once nothing allocated from it is alive.
+    std::shared_ptr<Arena> arena_;
 
     Camera camera(const Image &img) const { return cb_.build(img); }
 
     CameraBuilder cb_;
 };
-
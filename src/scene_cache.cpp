@@ -0,0 +1,76 @@
+#include "scene_cache.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include "scene.hpp"
+#include "serialization.hpp"
+
+// 64-bit FNV-1a, fixed so keys are stable across builds and platforms.
+static uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325) {
+    const auto *bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+uint64_t SceneCache::key(std::string_view contents) {
+    const uint32_t settings[] = {
+        SceneFile::VERSION,
+        static_cast<uint32_t>(CompiledScene::MAX_LEAF_SIZE),
+        sizeof(real),
+        sizeof(CompiledScene::Node),
+        sizeof(CompiledScene::SphereData),
+        sizeof(CompiledScene::QuadData),
+        sizeof(CompiledScene::TransformData),
+        sizeof(CompiledScene::MediumData),
+    };
+
+    return fnv1a(contents.data(), contents.size(), fnv1a(settings, sizeof(settings)));
+}
+
+SceneFile::Loaded SceneCache::load(const std::string &file_name, bool copy) const {
+    std::ifstream file(file_name, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error(std::format("Failed to open scene: {}.", file_name));
+    }
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    const std::string yaml = contents.str();
+
+    const auto path = dir_ / std::format("{:016x}.rtc", key(yaml));
+    if (std::filesystem::exists(path)) {
+        try {
+            auto loaded = SceneFile::load(path, copy);
+            std::clog << std::format("Loaded cached scene: {}\n", path.string());
+            return loaded;
+        } catch (const std::exception &err) {
+            std::clog << std::format("Ignoring cached scene: {}\n", err.what());
+        }
+    }
+
+    Scene scene = YAML::Load(yaml).as<Scene>();
+    SceneFile::Loaded loaded { scene.compile(), scene.cb_ };
+
+    // Write to a temporary file first so concurrent runs never map a
+    // partially written scene. Threads of one run (one per NUMA node) may
+    // miss together, so the name is unique per thread too.
+    const size_t thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    const auto tmp = std::filesystem::path(path).concat(std::format(".{}.{:x}.tmp", ::getpid(), thread));
+    try {
+        std::filesystem::create_directories(dir_);
+        SceneFile::write(tmp, *loaded.scene, loaded.cb);
+        std::filesystem::rename(tmp, path);
+    } catch (const std::exception &err) {
+        std::clog << std::format("Not caching scene: {}\n", err.what());
+        std::error_code ec;
+        std::filesystem::remove(tmp, ec);
+    }
+
+    return loaded;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "scene_file.hpp"
+
+// Directory of compiled scenes, keyed by a hash of the scene file's contents
+// and of the settings that shape the compiled layout. A hit maps the cached
+// scene file and skips YAML decoding and the BVH build; editing the scene
+// changes the key, so stale entries are never used. Camera overrides loaded
+// from a separate file don't affect the key.
+class SceneCache {
+public:
+    explicit SceneCache(std::filesystem::path dir) : dir_(std::move(dir)) {}
+
+    // Loads the YAML scene `file_name`, from the cache when possible. On a
+    // miss the scene is compiled and, if it can be written, stored. `copy` is
+    // passed on to `SceneFile::load` for hits.
+    SceneFile::Loaded load(const std::string &file_name, bool copy = false) const;
+
+    static uint64_t key(std::string_view contents);
+
+private:
+    std::filesystem::path dir_;
+};
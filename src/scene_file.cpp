@@ -0,0 +1,471 @@
+#include "scene_file.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include "trace.hpp"
+
+static_assert(std::is_trivially_copyable_v<CompiledScene::Node>);
+static_assert(std::is_trivially_copyable_v<CompiledScene::SphereData>);
+static_assert(std::is_trivially_copyable_v<CompiledScene::QuadData>);
+static_assert(std::is_trivially_copyable_v<CompiledScene::TransformData>);
+static_assert(std::is_trivially_copyable_v<CompiledScene::MediumData>);
+static_assert(std::is_trivially_copyable_v<CameraBuilder>);
+
+// Sections start on cache-line boundaries; the mapping itself is page aligned.
+static constexpr uint64_t SECTION_ALIGNMENT = 64;
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+class SceneFile::Writer {
+public:
+    template<typename T>
+    void put(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto *p = reinterpret_cast<const char*>(&value);
+        bytes_.insert(bytes_.end(), p, p + sizeof(T));
+    }
+
+    void put(const std::string &str) {
+        put(static_cast<uint32_t>(str.size()));
+        bytes_.insert(bytes_.end(), str.begin(), str.end());
+    }
+
+    template<typename T>
+    void put_array(std::span<const T> values) {
+        const auto *p = reinterpret_cast<const char*>(values.data());
+        bytes_.insert(bytes_.end(), p, p + values.size_bytes());
+    }
+
+    const std::vector<char>& bytes() const { return bytes_; }
+
+private:
+    std::vector<char> bytes_;
+};
+
+class SceneFile::Reader {
+public:
+    Reader(const char *begin, const char *end) : p_(begin), end_(end) {}
+
+    template<typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string get_string() {
+        const auto size = get<uint32_t>();
+        return std::string(take(size), size);
+    }
+
+    bool done() const { return p_ == end_; }
+
+private:
+    const char *p_;
+    const char *end_;
+
+    const char *take(size_t size) {
+        if (static_cast<size_t>(end_ - p_) < size) {
+            throw std::runtime_error("Truncated scene file.");
+        }
+
+        const char *p = p_;
+        p_ += size;
+        return p;
+    }
+};
+
+// Read-only mapping of a whole file, unmapped with the last scene using it.
+class Mapping {
+public:
+    explicit Mapping(const std::string &file_name) {
+        const int fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(std::format("Failed to open scene file: {}.", file_name));
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            size_ = st.st_size;
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+
+        if (data_ == MAP_FAILED || data_ == nullptr) {
+            throw std::runtime_error(std::format("Failed to map scene file: {}.", file_name));
+        }
+    }
+
+    ~Mapping() { ::munmap(data_, size_); }
+
+    Mapping(const Mapping &) = delete;
+    Mapping& operator=(const Mapping &) = delete;
+
+    const char *data() const { return static_cast<const char*>(data_); }
+    size_t size() const { return size_; }
+
+private:
+    void *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+SceneFile::Header SceneFile::expected_header() {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.layout[Nodes] = sizeof(CompiledScene::Node);
+    header.layout[Spheres] = sizeof(CompiledScene::SphereData);
+    header.layout[Quads] = sizeof(CompiledScene::QuadData);
+    header.layout[Transforms] = sizeof(CompiledScene::TransformData);
+    header.layout[Media] = sizeof(CompiledScene::MediumData);
+    header.layout[Camera] = sizeof(CameraBuilder);
+    header.real_size = sizeof(real);
+
+    return header;
+}
+
+void SceneFile::write(const std::string &file_name, const CompiledScene &scene, const CameraBuilder &cb) {
+    if (!scene.others_.empty()) {
+        throw std::runtime_error("Scene contains objects with no flat representation.");
+    }
+
+    Writer sections[NUM_SECTIONS];
+    sections[Nodes].put_array(scene.nodes_);
+    sections[Spheres].put_array(scene.spheres_);
+    sections[Quads].put_array(scene.quads_);
+    sections[Transforms].put_array(scene.transforms_);
+    sections[Media].put_array(scene.media_);
+    sections[Camera].put(cb);
+
+    std::vector<const Texture*> written;
+    for (const auto &mat : scene.materials_) {
+        write_material(*mat, sections[Materials], sections[Textures], written);
+    }
+
+    Header header = expected_header();
+    header.root = scene.root_;
+
+    uint64_t offset = sizeof(Header);
+    for (uint32_t s = 0; s < NUM_SECTIONS; s++) {
+        offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        header.offset[s] = offset;
+        header.size[s] = sections[s].bytes().size();
+        offset += header.size[s];
+    }
+
+    std::ofstream file(file_name, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error(std::format("Failed to open file: {}.", file_name));
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    for (uint32_t s = 0; s < NUM_SECTIONS; s++) {
+        const std::vector<char> padding(header.offset[s] - file.tellp(), 0);
+        file.write(padding.data(), padding.size());
+        file.write(sections[s].bytes().data(), sections[s].bytes().size());
+    }
+
+    if (!file) {
+        throw std::runtime_error(std::format("Failed to write file: {}.", file_name));
+    }
+}
+
+// Textures are written after the textures they refer to, so every index in a
+// record points backwards. Shared textures are written once.
+uint32_t SceneFile::write_texture(const std::shared_ptr<Texture> &tex, Writer &out, std::vector<const Texture*> &written) {
+    for (size_t i = 0; i < written.size(); i++) {
+        if (written[i] == tex.get()) return i;
+    }
+
+    const Texture &ref = *tex;
+    const auto &type = typeid(ref);
+
+    if (type == typeid(SolidColorTexture)) {
+        out.put(TextureType::SolidColor);
+        out.put(static_cast<const SolidColorTexture&>(ref).color_);
+    } else if (type == typeid(CheckerTexture)) {
+        const auto &checker = static_cast<const CheckerTexture&>(ref);
+        const uint32_t even = write_texture(checker.even_, out, written);
+        const uint32_t odd = write_texture(checker.odd_, out, written);
+        out.put(TextureType::Checker);
+        out.put(checker.scale_);
+        out.put(even);
+        out.put(odd);
+    } else if (type == typeid(ImageTexture)) {
+        out.put(TextureType::Image);
+        out.put(static_cast<const ImageTexture&>(ref).file_name_);
+    } else if (type == typeid(NoiseTexture)) {
+        out.put(TextureType::Noise);
+        out.put(static_cast<const NoiseTexture&>(ref).scale_);
+    } else {
+        throw std::runtime_error(std::format("Unsupported texture type: {}.", type.name()));
+    }
+
+    written.push_back(tex.get());
+    return written.size() - 1;
+}
+
+void SceneFile::write_material(const Material &mat, Writer &out, Writer &textures, std::vector<const Texture*> &written) {
+    switch (mat.kind()) {
+        case Material::Kind::Lambertian: {
+            const uint32_t tex = write_texture(static_cast<const Lambertian&>(mat).tex_, textures, written);
+            out.put(mat.kind());
+            out.put(tex);
+            break;
+        }
+        case Material::Kind::Metal: {
+            const auto &metal = static_cast<const Metal&>(mat);
+            out.put(mat.kind());
+            out.put(metal.color_);
+            out.put(metal.fuzz_);
+            break;
+        }
+        case Material::Kind::Dielectric:
+            out.put(mat.kind());
+            out.put(static_cast<const Dielectric&>(mat).refraction_index_);
+            break;
+        case Material::Kind::DiffuseLight: {
+            const uint32_t tex = write_texture(static_cast<const DiffuseLight&>(mat).tex_, textures, written);
+            out.put(mat.kind());
+            out.put(tex);
+            break;
+        }
+        case Material::Kind::Isotropic: {
+            const uint32_t tex = write_texture(static_cast<const Isotropic&>(mat).tex_, textures, written);
+            out.put(mat.kind());
+            out.put(tex);
+            break;
+        }
+        case Material::Kind::Other:
+            throw std::runtime_error(std::format("Unsupported material type: {}.", typeid(mat).name()));
+    }
+}
+
+bool SceneFile::is_scene_file(const std::string &file_name) {
+    std::ifstream file(file_name, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+SceneFile::Loaded SceneFile::load(const std::string &file_name, bool copy) {
+    TraceScope trace("load scene file", "load", std::format("\"file\": \"{}\"", Trace::escape(file_name)));
+    const auto mapping = std::make_shared<Mapping>(file_name);
+
+    Header header;
+    if (mapping->size() < sizeof(Header)) {
+        throw std::runtime_error(std::format("Not a scene file: {}.", file_name));
+    }
+    std::memcpy(&header, mapping->data(), sizeof(Header));
+
+    const Header expected = expected_header();
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(std::format("Not a scene file: {}.", file_name));
+    }
+
+    if (header.version != expected.version || header.byte_order != expected.byte_order || header.real_size != expected.real_size
+        || std::memcmp(header.layout, expected.layout, sizeof(header.layout)) != 0) {
+        throw std::runtime_error(std::format("Scene file {} was written by an incompatible build (version {}); recompile it.", file_name, header.version));
+    }
+
+    for (uint32_t s = 0; s < NUM_SECTIONS; s++) {
+        if (header.offset[s] % SECTION_ALIGNMENT != 0 || header.offset[s] > mapping->size() || header.size[s] > mapping->size() - header.offset[s]
+            || (header.layout[s] != 0 && header.size[s] % header.layout[s] != 0)) {
+            throw std::runtime_error(std::format("Corrupt scene file: {}.", file_name));
+        }
+    }
+
+    const auto section = [&](Section s) { return mapping->data() + header.offset[s]; };
+    const auto count = [&](Section s) { return header.size[s] / header.layout[s]; };
+
+    Loaded loaded;
+    loaded.scene = std::shared_ptr<CompiledScene>(new CompiledScene());
+    CompiledScene &scene = *loaded.scene;
+    scene.mapping_ = mapping;
+    scene.nodes_ = {reinterpret_cast<const CompiledScene::Node*>(section(Nodes)), count(Nodes)};
+    scene.spheres_ = {reinterpret_cast<const CompiledScene::SphereData*>(section(Spheres)), count(Spheres)};
+    scene.quads_ = {reinterpret_cast<const CompiledScene::QuadData*>(section(Quads)), count(Quads)};
+    scene.transforms_ = {reinterpret_cast<const CompiledScene::TransformData*>(section(Transforms)), count(Transforms)};
+    scene.media_ = {reinterpret_cast<const CompiledScene::MediumData*>(section(Media)), count(Media)};
+    scene.root_ = header.root;
+
+    if (scene.root_ >= scene.nodes_.size() || count(Camera) != 1) {
+        throw std::runtime_error(std::format("Corrupt scene file: {}.", file_name));
+    }
+    std::memcpy(&loaded.cb, section(Camera), sizeof(CameraBuilder));
+
+    std::vector<std::shared_ptr<Texture>> textures;
+    Reader texture_records(section(Textures), section(Textures) + header.size[Textures]);
+    while (!texture_records.done()) {
+        textures.push_back(read_texture(texture_records, textures));
+    }
+
+    Reader material_records(section(Materials), section(Materials) + header.size[Materials]);
+    while (!material_records.done()) {
+        scene.materials_.push_back(read_material(material_records, textures));
+    }
+
+    validate(scene, file_name);
+
+    if (copy) {
+        scene.arrays_.nodes.assign(scene.nodes_.begin(), scene.nodes_.end());
+        scene.arrays_.spheres.assign(scene.spheres_.begin(), scene.spheres_.end());
+        scene.arrays_.quads.assign(scene.quads_.begin(), scene.quads_.end());
+        scene.arrays_.transforms.assign(scene.transforms_.begin(), scene.transforms_.end());
+        scene.arrays_.media.assign(scene.media_.begin(), scene.media_.end());
+        scene.nodes_ = scene.arrays_.nodes;
+        scene.spheres_ = scene.arrays_.spheres;
+        scene.quads_ = scene.arrays_.quads;
+        scene.transforms_ = scene.arrays_.transforms;
+        scene.media_ = scene.arrays_.media;
+        scene.mapping_.reset();
+    }
+
+    return loaded;
+}
+
+void SceneFile::validate(const CompiledScene &scene, const std::string &file_name) {
+    using PrimType = CompiledScene::PrimType;
+    // Trees reached through transforms and media, each a recursive hit_tree.
+    constexpr uint32_t MAX_NESTING = 64;
+
+    const auto corrupt = [&](std::string_view what) {
+        return std::runtime_error(std::format("Corrupt scene file: {} ({}).", file_name, what));
+    };
+
+    const size_t num_materials = scene.materials_.size();
+    for (const auto &sphere : scene.spheres_) {
+        if (sphere.mat >= num_materials) throw corrupt("bad sphere material");
+    }
+    for (const auto &quad : scene.quads_) {
+        if (quad.mat >= num_materials) throw corrupt("bad quad material");
+    }
+    for (const auto &medium : scene.media_) {
+        if (medium.mat >= num_materials) throw corrupt("bad medium material");
+    }
+
+    // Interior levels and nesting below each node, filled in once it's done.
+    struct Height {
+        uint32_t levels = 0, nesting = 0;
+    };
+    enum class State : uint8_t { New, Visiting, Done };
+    const auto &nodes = scene.nodes_;
+    std::vector<State> states(nodes.size(), State::New);
+    std::vector<Height> heights(nodes.size());
+
+    // `levels` and `nesting` are those above `index`, so the recursion stops
+    // at the limits whatever the file holds.
+    std::function<Height(uint32_t, uint32_t, uint32_t)> visit = [&](uint32_t index, uint32_t levels, uint32_t nesting) -> Height {
+        if (index >= nodes.size()) throw corrupt("bad node index");
+        if (states[index] == State::Visiting) throw corrupt("cycle in the node graph");
+        if (states[index] == State::Done) {
+            const Height height = heights[index];
+            if (levels + height.levels + 1 > CompiledScene::STACK_SIZE) throw corrupt("tree too deep");
+            if (nesting + height.nesting > MAX_NESTING) throw corrupt("transforms nested too deeply");
+            return height;
+        }
+
+        states[index] = State::Visiting;
+        const CompiledScene::Node &node = nodes[index];
+        Height height;
+        if (node.count == 0) {
+            if (node.offset != 0) {
+                // Interior, its left child is the next node.
+                if (node.axis > 2) throw corrupt("bad split axis");
+                if (levels + 2 > CompiledScene::STACK_SIZE) throw corrupt("tree too deep");
+                const Height left = visit(index + 1, levels + 1, nesting);
+                const Height right = visit(node.offset, levels + 1, nesting);
+                height = { std::max(left.levels, right.levels) + 1, std::max(left.nesting, right.nesting) };
+            }
+        } else {
+            const uint64_t end = uint64_t(node.offset) + node.count;
+            const auto in_range = [&](size_t size) {
+                if (end > size) throw corrupt("bad primitive range");
+            };
+            // Each nested tree starts a new stack.
+            const auto nested = [&](uint32_t root) {
+                if (nesting + 1 > MAX_NESTING) throw corrupt("transforms nested too deeply");
+                height.nesting = std::max(height.nesting, visit(root, 0, nesting + 1).nesting + 1);
+            };
+            switch (node.type) {
+                case PrimType::Sphere:
+                    in_range(scene.spheres_.size());
+                    break;
+                case PrimType::Quad:
+                    in_range(scene.quads_.size());
+                    break;
+                case PrimType::Transform:
+                    in_range(scene.transforms_.size());
+                    for (uint64_t i = node.offset; i < end; i++) nested(scene.transforms_[i].root);
+                    break;
+                case PrimType::Medium:
+                    in_range(scene.media_.size());
+                    for (uint64_t i = node.offset; i < end; i++) nested(scene.media_[i].boundary);
+                    break;
+                default:
+                    // Other leaves can't be written to a file.
+                    throw corrupt("bad leaf type");
+            }
+        }
+
+        states[index] = State::Done;
+        heights[index] = height;
+        return height;
+    };
+
+    visit(scene.root_, 0, 0);
+}
+
+static const std::shared_ptr<Texture>& texture_at(const std::vector<std::shared_ptr<Texture>> &textures, uint32_t index) {
+    if (index >= textures.size()) {
+        throw std::runtime_error("Corrupt scene file: bad texture index.");
+    }
+
+    return textures[index];
+}
+
+std::shared_ptr<Texture> SceneFile::read_texture(Reader &in, const std::vector<std::shared_ptr<Texture>> &textures) {
+    switch (in.get<TextureType>()) {
+        case TextureType::SolidColor:
+            return std::make_shared<SolidColorTexture>(in.get<Color>());
+        case TextureType::Checker: {
+            const auto scale = in.get<real>();
+            const auto even = in.get<uint32_t>();
+            const auto odd = in.get<uint32_t>();
+            return std::make_shared<CheckerTexture>(scale, texture_at(textures, even), texture_at(textures, odd));
+        }
+        case TextureType::Image:
+            return std::make_shared<ImageTexture>(in.get_string().c_str());
+        case TextureType::Noise:
+            return std::make_shared<NoiseTexture>(in.get<real>());
+    }
+
+    throw std::runtime_error("Corrupt scene file: bad texture type.");
+}
+
+std::shared_ptr<Material> SceneFile::read_material(Reader &in, const std::vector<std::shared_ptr<Texture>> &textures) {
+    switch (in.get<Material::Kind>()) {
+        case Material::Kind::Lambertian:
+            return std::make_shared<Lambertian>(texture_at(textures, in.get<uint32_t>()));
+        case Material::Kind::Metal: {
+            const auto color = in.get<Color>();
+            return std::make_shared<Metal>(color, in.get<real>());
+        }
+        case Material::Kind::Dielectric:
+            return std::make_shared<Dielectric>(in.get<real>());
+        case Material::Kind::DiffuseLight:
+            return std::make_shared<DiffuseLight>(texture_at(textures, in.get<uint32_t>()));
+        case Material::Kind::Isotropic:
+            return std::make_shared<Isotropic>(texture_at(textures, in.get<uint32_t>()));
+        case Material::Kind::Other:
+            break;
+    }
+
+    throw std::runtime_error("Corrupt scene file: bad material kind.");
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "camera.hpp"
+#include "compiled_scene.hpp"
+#include "material.hpp"
+#include "texture.hpp"
+
+// Binary file holding a compiled scene and its camera, written by the
+// `compile` tool. The node and primitive arrays are stored exactly as they
+// are laid out in memory, so loading maps the file and points the scene at
+// them without parsing or copying. Only the (few) materials and textures are
+// rebuilt from compact records.
+//
+// Files are tied to the build that wrote them: the header records the format
+// version and the sizes of `real` and of every stored struct, and a file whose
+// layout differs from this build's is rejected.
+class SceneFile {
+public:
+    static constexpr char MAGIC[8] = {'R', 'T', 'S', 'C', 'E', 'N', 'E', '\n'};
+    static constexpr uint32_t VERSION = 1;
+
+    struct Loaded {
+        std::shared_ptr<CompiledScene> scene;
+        CameraBuilder cb;
+    };
+
+    // Writes `scene` and `cb` to `file_name`. Throws `std::runtime_error` if
+    // the scene has primitives with no flat form or the file can't be written.
+    static void write(const std::string &file_name, const CompiledScene &scene, const CameraBuilder &cb);
+
+    // Maps a file written by `write`. With `copy`, the node and primitive
+    // arrays are copied into memory owned by the scene, allocated by the
+    // calling thread, and the file is unmapped. Throws `std::runtime_error`
+    // if it can't be read or was written by an incompatible build.
+    static Loaded load(const std::string &file_name, bool copy = false);
+
+    // Whether `file_name` starts with MAGIC.
+    static bool is_scene_file(const std::string &file_name);
+
+private:
+    enum Section : uint32_t { Nodes, Spheres, Quads, Transforms, Media, Textures, Materials, Camera, NUM_SECTIONS };
+
+    enum class TextureType : uint8_t { SolidColor, Checker, Image, Noise };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t layout[NUM_SECTIONS];  // Element size of each array section, 0 for byte streams.
+        uint32_t real_size;
+        uint32_t root;
+        uint64_t offset[NUM_SECTIONS];
+        uint64_t size[NUM_SECTIONS];    // In bytes.
+    };
+
+    static Header expected_header();
+
+    class Writer;
+    class Reader;
+
+    static uint32_t write_texture(const std::shared_ptr<Texture> &tex, Writer &out, std::vector<const Texture*> &written);
+    static void write_material(const Material &mat, Writer &out, Writer &textures, std::vector<const Texture*> &written);
+    static std::shared_ptr<Texture> read_texture(Reader &in, const std::vector<std::shared_ptr<Texture>> &textures);
+    static std::shared_ptr<Material> read_material(Reader &in, const std::vector<std::shared_ptr<Texture>> &textures);
+
+    // Checks every index of the loaded `scene` against its arrays, and that
+    // its trees fit the traversal stack and their transforms and media nest
+    // without cycles. Throws `std::runtime_error` naming `file_name` if not.
+    static void validate(const CompiledScene &scene, const std::string &file_name);
+};
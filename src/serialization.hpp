@@ -1,5 +1,6 @@
 #pragma once
 
+#include "arena.hpp"
 #include "bvh.hpp"
 #include "camera.hpp"
 #include "hittable.hpp"
@@ -13,6 +14,9 @@
 #include "sphere.hpp"
 #include "quad.hpp"
 #include "constant_medium.hpp"
+#include "instance.hpp"
+#include "trace.hpp"
+#include "transform.hpp"
 #include "yaml-cpp/emitter.h"
 #include "yaml-cpp/emittermanip.h"
 #include "yaml-cpp/node/node.h"
@@ -63,9 +67,9 @@ struct convert<Color> {
     static bool decode(const Node &node, Color &rhs) {
         if (!node.IsSequence() || node.size() != 3) { return false; }
 
-        rhs.elem[0] = node[0].as<double>();
-        rhs.elem[1] = node[1].as<double>();
-        rhs.elem[2] = node[2].as<double>();
+        rhs.elem[0] = node[0].as<real>();
+        rhs.elem[1] = node[1].as<real>();
+        rhs.elem[2] = node[2].as<real>();
 
         return true;
     }
@@ -83,7 +87,7 @@ struct convert<std::shared_ptr<SolidColorTexture>> {
     static bool decode(const Node &node, std::shared_ptr<SolidColorTexture> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "solid_color") return false;
 
-        rhs = std::make_shared<SolidColorTexture>(node["color"].as<Color>());
+        rhs = make_arena_shared<SolidColorTexture>(node["color"].as<Color>());
         return true;
     }
 };
@@ -120,11 +124,11 @@ struct convert<std::shared_ptr<CheckerTexture>> {
     static bool decode(const Node &node, std::shared_ptr<CheckerTexture> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "checker") return false;
 
-        const auto scale = node["scale"].as<double>();
+        const auto scale = node["scale"].as<real>();
         const auto even = node["even"].as<std::shared_ptr<Texture>>();
         const auto odd = node["odd"].as<std::shared_ptr<Texture>>();
 
-        rhs = std::make_shared<CheckerTexture>(scale, even, odd);
+        rhs = make_arena_shared<CheckerTexture>(scale, even, odd);
 
         return true;
     }
@@ -132,7 +136,7 @@ struct convert<std::shared_ptr<CheckerTexture>> {
     static bool decode(const Node &node, const std::unordered_map<std::string, std::shared_ptr<Texture>> &refs, std::shared_ptr<CheckerTexture> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "checker") return false;
 
-        const auto scale = node["scale"].as<double>();
+        const auto scale = node["scale"].as<real>();
 
         std::shared_ptr<Texture> even;
         if (node["even"].IsScalar()) {
@@ -148,7 +152,7 @@ struct convert<std::shared_ptr<CheckerTexture>> {
             odd = node["odd"].as<std::shared_ptr<Texture>>();
         }
 
-        rhs = std::make_shared<CheckerTexture>(scale, even, odd);
+        rhs = make_arena_shared<CheckerTexture>(scale, even, odd);
 
         return true;
     }
@@ -166,7 +170,7 @@ struct convert<std::shared_ptr<ImageTexture>> {
     static bool decode(const Node &node, std::shared_ptr<ImageTexture> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "image") return false;
 
-        rhs = std::make_shared<ImageTexture>(node["file_name"].as<std::string>().c_str());
+        rhs = make_arena_shared<ImageTexture>(node["file_name"].as<std::string>().c_str());
 
         return true;
     }
@@ -186,8 +190,8 @@ struct convert<std::shared_ptr<NoiseTexture>> {
     static bool decode(const Node &node, std::shared_ptr<NoiseTexture> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "noise") return false;
 
-        const auto scale = node["scale"].as<double>();
-        rhs = std::make_shared<NoiseTexture>(scale);
+        const auto scale = node["scale"].as<real>();
+        rhs = make_arena_shared<NoiseTexture>(scale);
 
         return true;
     }
@@ -292,7 +296,7 @@ struct convert<std::shared_ptr<Lambertian>> {
         if (!node.IsMap() || node["type"].as<std::string>() != Lambertian::NAME) return false;
 
         std::shared_ptr<Texture> tex = node["texture"].as<std::shared_ptr<Texture>>();
-        rhs = std::make_shared<Lambertian>(tex);
+        rhs = make_arena_shared<Lambertian>(tex);
 
         return true;
     }
@@ -301,9 +305,9 @@ struct convert<std::shared_ptr<Lambertian>> {
         if (!node.IsMap() || node["type"].as<std::string>() != Lambertian::NAME) { return false; }
 
         if (node["texture"].IsScalar()) {
-            rhs = std::make_shared<Lambertian>(textures.at(node["texture"].as<std::string>()));
+            rhs = make_arena_shared<Lambertian>(textures.at(node["texture"].as<std::string>()));
         } else {
-            rhs = std::make_shared<Lambertian>(node["texture"].as<std::shared_ptr<Texture>>());
+            rhs = make_arena_shared<Lambertian>(node["texture"].as<std::shared_ptr<Texture>>());
         }
 
         return true;
@@ -324,7 +328,7 @@ struct convert<std::shared_ptr<Metal>> {
     static bool decode(const Node &node, std::shared_ptr<Metal> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != Metal::NAME) return false;
 
-        rhs = std::make_shared<Metal>(node["color"].as<Color>(), node["fuzz"].as<double>());
+        rhs = make_arena_shared<Metal>(node["color"].as<Color>(), node["fuzz"].as<real>());
 
         return true;
     }
@@ -341,9 +345,11 @@ struct convert<std::shared_ptr<Dielectric>> {
     }
 
     static bool decode(const Node &node, std::shared_ptr<Dielectric> &rhs) {
-        if (!node.IsMap() || node["type"].as<std::string>() != Dielectric::NAME) return false;
+        if (!node.IsMap()) return false;
+        const auto type = node["type"].as<std::string>();
+        if (type != Dielectric::NAME && type != Dielectric::ALIAS) return false;
 
-        rhs = std::make_shared<Dielectric>(node["refraction_index"].as<double>());
+        rhs = make_arena_shared<Dielectric>(node["refraction_index"].as<real>());
 
         return true;
     }
@@ -374,16 +380,20 @@ struct convert<std::shared_ptr<DiffuseLight>> {
     }
 
     static bool decode(const Node &node, std::shared_ptr<DiffuseLight> &rhs) {
-        if (!node.IsMap() || node["type"].as<std::string>() != DiffuseLight::NAME) return false;
+        if (!node.IsMap()) return false;
+        const auto type = node["type"].as<std::string>();
+        if (type != DiffuseLight::NAME && type != DiffuseLight::ALIAS) return false;
 
         const auto tex = node["texture"].as<std::shared_ptr<Texture>>();
-        rhs = std::make_shared<DiffuseLight>(tex);
+        rhs = make_arena_shared<DiffuseLight>(tex);
 
         return true;
     }
 
     static bool decode(const Node &node, const std::unordered_map<std::string, std::shared_ptr<Texture>> &textures, std::shared_ptr<DiffuseLight> &rhs) {
-        if (!node.IsMap() || node["type"].as<std::string>() != DiffuseLight::NAME) return false;
+        if (!node.IsMap()) return false;
+        const auto type = node["type"].as<std::string>();
+        if (type != DiffuseLight::NAME && type != DiffuseLight::ALIAS) return false;
 
         std::shared_ptr<Texture> tex;
         if (node["texture"].IsScalar()) {
@@ -392,7 +402,7 @@ struct convert<std::shared_ptr<DiffuseLight>> {
             tex = node["texture"].as<std::shared_ptr<Texture>>();
         }
 
-        rhs = std::make_shared<DiffuseLight>(tex);
+        rhs = make_arena_shared<DiffuseLight>(tex);
 
         return true;
     }
@@ -427,7 +437,7 @@ struct convert<std::shared_ptr<Isotropic>> {
 
         const auto tex = node["texture"].as<std::shared_ptr<Texture>>();
 
-        rhs = std::make_shared<Isotropic>(tex);
+        rhs = make_arena_shared<Isotropic>(tex);
 
         return true;
     }
@@ -442,7 +452,7 @@ struct convert<std::shared_ptr<Isotropic>> {
             tex = node["texture"].as<std::shared_ptr<Texture>>();
         }
 
-        rhs = std::make_shared<Isotropic>(tex);
+        rhs = make_arena_shared<Isotropic>(tex);
 
         return true;
     }
@@ -497,10 +507,10 @@ struct convert<std::shared_ptr<Material>> {
         } else if (type == Metal::NAME) {
             rhs = node.as<std::shared_ptr<Metal>>();
             return true;
-        } else if (type == Dielectric::NAME) {
+        } else if (type == Dielectric::NAME || type == Dielectric::ALIAS) {
             rhs = node.as<std::shared_ptr<Dielectric>>();
             return true;
-        } else if (type == DiffuseLight::NAME) {
+        } else if (type == DiffuseLight::NAME || type == DiffuseLight::ALIAS) {
             std::shared_ptr<DiffuseLight> p;
             if (convert<std::shared_ptr<DiffuseLight>>::decode(node, textures, p)) {
                 rhs = p;
@@ -525,10 +535,10 @@ struct convert<std::shared_ptr<Material>> {
         } else if (type == Metal::NAME) {
             rhs = node.as<std::shared_ptr<Metal>>();
             return true;
-        } else if (type == Dielectric::NAME) {
+        } else if (type == Dielectric::NAME || type == Dielectric::ALIAS) {
             rhs = node.as<std::shared_ptr<Dielectric>>();
             return true;
-        } else if (type == DiffuseLight::NAME) {
+        } else if (type == DiffuseLight::NAME || type == DiffuseLight::ALIAS) {
             rhs = node.as<std::shared_ptr<DiffuseLight>>();
             return true;
         } else if (type == Isotropic::NAME) {
@@ -556,9 +566,9 @@ struct convert<Point3<T>> {
     static bool decode(const Node &node, Point3<T> &rhs) {
         if (!node.IsSequence() || node.size() != 3)  return false;
 
-        rhs.elem[0] = node[0].as<double>();
-        rhs.elem[1] = node[1].as<double>();
-        rhs.elem[2] = node[2].as<double>();
+        rhs.elem[0] = node[0].as<real>();
+        rhs.elem[1] = node[1].as<real>();
+        rhs.elem[2] = node[2].as<real>();
 
         return true;
     }
@@ -614,11 +624,11 @@ struct convert<std::shared_ptr<Sphere>> {
     static bool decode(const Node &node, std::shared_ptr<Sphere> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "sphere") return false;
 
-        const auto origin = node["origin"].as<Ray<double>>();
-        const auto radius = node["radius"].as<double>();
+        const auto origin = node["origin"].as<Ray<real>>();
+        const auto radius = node["radius"].as<real>();
         const auto mat = node["material"].as<std::shared_ptr<Material>>();
 
-        rhs = std::make_shared<Sphere>(origin, radius, mat);
+        rhs = make_arena_shared<Sphere>(origin, radius, mat);
 
         return true;
     }
@@ -626,8 +636,8 @@ struct convert<std::shared_ptr<Sphere>> {
     static bool decode(const Node &node, const std::unordered_map<std::string, std::shared_ptr<Material>> &materials, const std::unordered_map<std::string, std::shared_ptr<Texture>> &textures,std::shared_ptr<Sphere> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "sphere") return false;
 
-        const auto origin = node["origin"].as<Ray<double>>();
-        const auto radius = node["radius"].as<double>();
+        const auto origin = node["origin"].as<Ray<real>>();
+        const auto radius = node["radius"].as<real>();
 
         std::shared_ptr<Material> mat;
         if (node["material"].IsScalar()) {
@@ -635,7 +645,7 @@ struct convert<std::shared_ptr<Sphere>> {
         } else if (!convert<std::shared_ptr<Material>>::decode(node["material"], textures, mat)) {
             return false;
         }
-        rhs = std::make_shared<Sphere>(origin, radius, mat);
+        rhs = make_arena_shared<Sphere>(origin, radius, mat);
         
         return true;
     }
@@ -674,9 +684,9 @@ struct convert<std::shared_ptr<Quad>> {
     static bool decode(const Node &node, const std::unordered_map<std::string, std::shared_ptr<Material>> &materials, const std::unordered_map<std::string, std::shared_ptr<Texture>> &textures, std::shared_ptr<Quad> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "quad") return false;
 
-        const auto origin = node["origin"].as<Point3<double>>();
-        const auto u = node["u"].as<Vec3<double>>();
-        const auto v = node["v"].as<Vec3<double>>();
+        const auto origin = node["origin"].as<Point3<real>>();
+        const auto u = node["u"].as<Vec3<real>>();
+        const auto v = node["v"].as<Vec3<real>>();
         std::shared_ptr<Material> mat;
         if (node["material"].IsScalar()) {
             mat = materials.at(node["material"].as<std::string>());
@@ -686,7 +696,7 @@ struct convert<std::shared_ptr<Quad>> {
             }
         }
 
-        rhs = std::make_shared<Quad>(origin, u, v, mat);
+        rhs = make_arena_shared<Quad>(origin, u, v, mat);
 
         return true;
     }
@@ -694,12 +704,12 @@ struct convert<std::shared_ptr<Quad>> {
     static bool decode(const Node &node, std::shared_ptr<Quad> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != "quad") return false;
 
-        const auto origin = node["origin"].as<Point3<double>>();
-        const auto u = node["u"].as<Vec3<double>>();
-        const auto v = node["v"].as<Vec3<double>>();
+        const auto origin = node["origin"].as<Point3<real>>();
+        const auto u = node["u"].as<Vec3<real>>();
+        const auto v = node["v"].as<Vec3<real>>();
         const auto mat = node["material"].as<std::shared_ptr<Material>>();
 
-        rhs = std::make_shared<Quad>(origin, u, v, mat);
+        rhs = make_arena_shared<Quad>(origin, u, v, mat);
 
         return true;
     }
@@ -751,7 +761,7 @@ struct convert<std::shared_ptr<BVHNode>> {
         const auto left = node["left"].as<std::shared_ptr<Hittable>>();
         const auto right = node["right"].as<std::shared_ptr<Hittable>>();
 
-        rhs = std::make_shared<BVHNode>(left, right);
+        rhs = make_arena_shared<BVHNode>(left, right);
 
         return true;
     }
@@ -776,7 +786,7 @@ struct convert<std::shared_ptr<BVHNode>> {
             }
         }
 
-        rhs = std::make_shared<BVHNode>(left, right);
+        rhs = make_arena_shared<BVHNode>(left, right);
 
         return true;
     }
@@ -817,7 +827,7 @@ struct convert<std::shared_ptr<HittableList>> {
     static bool decode(const Node &node, std::shared_ptr<HittableList> &rhs) {
         if (!node.IsMap() || node["type"].as<std::string>() != HittableList::NAME) return false;
 
-        rhs = std::make_shared<HittableList>();
+        rhs = make_arena_shared<HittableList>();
         if (node["objects"].IsDefined() && node["objects"].IsSequence()) {
             for (const auto obj_node : node["objects"]) {
                 rhs->add(obj_node.as<std::shared_ptr<Hittable>>());
@@ -830,7 +840,7 @@ struct convert<std::shared_ptr<HittableList>> {
     static bool decode(const Node &node, const std::unordered_map<std::string, std::shared_ptr<Hittable>> &refs, const std::unordered_map<std::string, std::shared_ptr<Material>> &materials, const std::unordered_map<std::string, std::shared_ptr<Texture>> &textures, std::shared_ptr<HittableList> &rhs){
         if (!node.IsMap() || node["type"].as<std::string>() != HittableList::NAME) return false;
 
-        rhs = std::make_shared<HittableList>();
+        rhs = make_arena_shared<HittableList>();
         if (node["objects"].IsDefined() && node["objects"].IsSequence()) {
             for (const auto obj_node : node["objects"]) {
                 if (obj_node.IsScalar()) {
@@ -886,10 +896,10 @@ struct convert<std::shared_ptr<Box>> {
             return false;
         }
 
-        const auto a = node["a"].as<Point3<double>>();
-        const auto b = node["b"].as<Point3<double>>();
+        const auto a = node["a"].as<Point3<real>>();
+        const auto b = node["b"].as<Point3<real>>();
 
-        rhs = std::make_shared<Box>(a, b, mat);
+        rhs = make_arena_shared<Box>(a, b, mat);
 
         return true;
     }
@@ -905,10 +915,10 @@ struct convert<std::shared_ptr<Box>> {
             return false;
         }
 
-        const auto a = node["a"].as<Point3<double>>();
-        const auto b = node["b"].as<Point3<double>>();
+        const auto a = node["a"].as<Point3<real>>();
+        const auto b = node["b"].as<Point3<real>>();
 
-        rhs = std::make_shared<Box>(a, b, mat);
+        rhs = make_arena_shared<Box>(a, b, mat);
 
         return true;
     }
@@ -948,9 +958,9 @@ struct convert<std::shared_ptr<Translate>> {
             return false;
         }
 
-        const auto offset = node["offset"].as<Vec3<double>>();
+        const auto offset = node["offset"].as<Vec3<real>>();
 
-        rhs = std::make_shared<Translate>(object, offset);
+        rhs = make_arena_shared<Translate>(object, offset);
 
         return true;
     }
@@ -967,9 +977,9 @@ struct convert<std::shared_ptr<Translate>> {
             }
         }
 
-        const auto offset = node["offset"].as<Vec3<double>>();
+        const auto offset = node["offset"].as<Vec3<real>>();
 
-        rhs = std::make_shared<Translate>(object, offset);
+        rhs = make_arena_shared<Translate>(object, offset);
 
         return true;
     }
@@ -1010,9 +1020,9 @@ struct convert<std::shared_ptr<RotateY>> {
             return false;
         }
 
-        const auto angle = node["angle"].as<double>();
+        const auto angle = node["angle"].as<real>();
 
-        rhs = std::make_shared<RotateY>(object, angle);
+        rhs = make_arena_shared<RotateY>(object, angle);
 
         return true;
     }
@@ -1029,9 +1039,9 @@ struct convert<std::shared_ptr<RotateY>> {
             }
         }
 
-        const auto angle = node["angle"].as<double>();
+        const auto angle = node["angle"].as<real>();
 
-        rhs = std::make_shared<RotateY>(object, angle);
+        rhs = make_arena_shared<RotateY>(object, angle);
 
         return true;
     }
@@ -1073,14 +1083,14 @@ struct convert<std::shared_ptr<ConstantMedium>> {
             return false;
         }
 
-        const auto density = node["density"].as<double>();
+        const auto density = node["density"].as<real>();
 
         std::shared_ptr<Material> phase_function;
         if (!convert<std::shared_ptr<Material>>::decode(node["phase_function"], phase_function)) {
             return false;
         }
 
-        rhs = std::make_shared<ConstantMedium>(boundary, density, phase_function);
+        rhs = make_arena_shared<ConstantMedium>(boundary, density, phase_function);
  
         return true;
     }
@@ -1096,7 +1106,7 @@ struct convert<std::shared_ptr<ConstantMedium>> {
                 return false;
             }
         }
-        const auto density = node["density"].as<double>();
+        const auto density = node["density"].as<real>();
         std::shared_ptr<Material> phase_function;
         if (node["phase_function"].IsScalar()) {
             phase_function = materials.at(node["phase_function"].as<std::string>());
@@ -1106,13 +1116,60 @@ struct convert<std::shared_ptr<ConstantMedium>> {
             }
         }
 
-        rhs = std::make_shared<ConstantMedium>(boundary, density, phase_function);
+        rhs = make_arena_shared<ConstantMedium>(boundary, density, phase_function);
  
         return true;
     }
 };
 
 
+template<>
+struct convert<Transform> {
+    static Node encode(const Transform &rhs) {
+        Node node;
+
+        node["translate"] = rhs.translation();
+        node["rotate"] = rhs.rotation();
+        node["scale"] = rhs.scale();
+
+        return node;
+    }
+
+    static bool decode(const Node &node, Transform &rhs) {
+        if (!node.IsMap()) return false;
+
+        Vec3<real> translation;
+        if (node["translate"].IsDefined()) {
+            translation = node["translate"].as<Vec3<real>>();
+        }
+
+        Vec3<real> rotation;
+        if (node["rotate"].IsDefined()) {
+            rotation = node["rotate"].as<Vec3<real>>();
+        } else if (node["rotate_y"].IsDefined()) {
+            rotation = Vec3<real>(0.0, node["rotate_y"].as<real>(), 0.0);
+        }
+
+        Vec3<real> scale(1.0, 1.0, 1.0);
+        if (node["scale"].IsDefined()) {
+            if (node["scale"].IsScalar()) {
+                const auto s = node["scale"].as<real>();
+                scale = Vec3<real>(s, s, s);
+            } else {
+                scale = node["scale"].as<Vec3<real>>();
+            }
+        }
+        // Transform divides by each component to invert the scale.
+        if (scale.x() == 0 || scale.y() == 0 || scale.z() == 0) {
+            throw std::runtime_error(std::format("Invalid transform scale: [{}, {}, {}], components must be non-zero.", scale.x(), scale.y(), scale.z()));
+        }
+
+        rhs = Transform(translation, rotation, scale);
+
+        return true;
+    }
+};
+
 template<>
 struct convert<Scene> {
     static Node encode(const Scene &rhs) {
@@ -1182,6 +1239,21 @@ struct convert<Scene> {
             }
         }
 
+        {
+            // Encode Instances
+            std::unordered_map<std::shared_ptr<Hittable>, std::string> blas_name_map;
+            for (const auto &[ref, blas] : rhs.blas_) {
+                blas_name_map[blas] = ref_name_map[ref];
+            }
+
+            node["instances"] = Node();
+            for (const auto &instance : rhs.instances_) {
+                Node instance_node = convert<Transform>::encode(instance->transform());
+                instance_node["ref"] = blas_name_map[instance->object()];
+                node["instances"].push_back(instance_node);
+            }
+        }
+
         node["camera"] = rhs.cb_;
 
         return node;
@@ -1189,6 +1261,8 @@ struct convert<Scene> {
 
     static bool decode(const Node &node, Scene &rhs) {
         if (!node.IsMap()) { return false; }
+
+        ArenaScope scope(rhs.arena_);
         
         // Create Name-Maps
         std::unordered_map<std::string, std::shared_ptr<Texture>> tex_map;
@@ -1252,6 +1326,18 @@ struct convert<Scene> {
             }
         }
 
+        Node instances_node = node["instances"];
+        if (instances_node.IsDefined() && instances_node.IsSequence()) {
+            for (const auto &instance_node : instances_node) {
+                const auto ref = ref_map.find(instance_node["ref"].as<std::string>());
+                if (ref == ref_map.end()) {
+                    return false;
+                }
+
+                rhs.add_instance(ref->second, instance_node.as<Transform>());
+            }
+        }
+
         Node camera_node = node["camera"];
         if (camera_node.IsDefined()) {
             rhs.cb_ = camera_node.as<CameraBuilder>();
@@ -1282,27 +1368,27 @@ struct convert<CameraBuilder> {
 
         
         if (node["look_at"].IsDefined()) {
-            rhs.lookat_ = node["look_at"].as<Point3<double>>();
+            rhs.lookat_ = node["look_at"].as<Point3<real>>();
         }
 
         if (node["look_from"].IsDefined()) {
-            rhs.lookfrom_ = node["look_from"].as<Point3<double>>();
+            rhs.lookfrom_ = node["look_from"].as<Point3<real>>();
         }
 
         if (node["vup"].IsDefined()) {
-            rhs.vup_ = node["vup"].as<Vec3<double>>();
+            rhs.vup_ = node["vup"].as<Vec3<real>>();
         }
 
         if (node["vfov"].IsDefined()) {
-            rhs.vfov_ = node["vfov"].as<double>();
+            rhs.vfov_ = node["vfov"].as<real>();
         }
 
         if (node["focus_dist"].IsDefined()) {
-            rhs.focus_dist_ = node["focus_dist"].as<double>();
+            rhs.focus_dist_ = node["focus_dist"].as<real>();
         }
 
         if (node["defocus_angle"].IsDefined()) {
-            rhs.defocus_angle_ = node["defocus_angle"].as<double>();
+            rhs.defocus_angle_ = node["defocus_angle"].as<real>();
         }
 
         if (node["background"].IsDefined()) {
@@ -1323,6 +1409,10 @@ struct convert<RenderSettings> {
         node["samples_per_pixel"] = rhs.samples_per_pixel_;
         node["chunk_width"] = rhs.chunk_width_;
         node["chunk_height"] = rhs.chunk_height_;
+        node["packets"] = rhs.packets_;
+        node["integrator"] = rhs.integrator_ == Integrator::Wavefront ? "wavefront" : "recursive";
+        node["seed"] = rhs.seed_;
+        node["pin_threads"] = rhs.pin_threads_;
 
         return node;
     }
@@ -1350,6 +1440,29 @@ struct convert<RenderSettings> {
             rhs.chunk_height_ = node["chunk_height"].as<int32_t>();
         }
 
+        if (node["packets"].IsDefined()) {
+            rhs.packets_ = node["packets"].as<bool>();
+        }
+
+        if (node["seed"].IsDefined()) {
+            rhs.seed_ = node["seed"].as<uint64_t>();
+        }
+
+        if (node["pin_threads"].IsDefined()) {
+            rhs.pin_threads_ = node["pin_threads"].as<bool>();
+        }
+
+        if (node["integrator"].IsDefined()) {
+            const auto integrator = node["integrator"].as<std::string>();
+            if (integrator == "wavefront") {
+                rhs.integrator_ = Integrator::Wavefront;
+            } else if (integrator == "recursive") {
+                rhs.integrator_ = Integrator::Recursive;
+            } else {
+                return false;
+            }
+        }
+
         return true;
     }
 };
@@ -1384,7 +1497,12 @@ inline std::ostream& operator<<(std::ostream& out, const RenderSettings& rs) {
 
 
 inline Scene LoadScene(const std::string &file_name) {
-    YAML::Node node = YAML::LoadFile(file_name);
+    TraceScope load("load scene", "load", std::format("\"file\": \"{}\"", Trace::escape(file_name)));
+    YAML::Node node;
+    {
+        TraceScope parse("parse YAML", "load");
+        node = YAML::LoadFile(file_name);
+    }
     return node.as<Scene>();
 }
 
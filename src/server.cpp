@@ -0,0 +1,45 @@
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include "cpu_count.hpp"
+#include "render_server.hpp"
+#include "argparse/argparse.hpp"
+
+// Render daemon; submit jobs to it with `main --server <socket> ...`.
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser program("server");
+
+    program.add_argument("socket")
+        .help("path of the Unix domain socket to listen on.");
+
+    program.add_argument("-n", "--num-threads")
+        .help("number of worker threads.")
+        .scan<'i', uint32_t>();
+
+    program.add_argument("--max-scenes")
+        .help("number of decoded scenes kept loaded.")
+        .default_value(uint32_t(4))
+        .scan<'i', uint32_t>();
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return EXIT_FAILURE;
+    }
+
+    const CpuCount &cpus = CpuCount::get();
+    std::clog << std::format("Detected {} CPUs from {}.\n", cpus.count, cpus.source);
+    const uint32_t num_threads = program.present<uint32_t>("num-threads").value_or(cpus.count);
+
+    try {
+        RenderServer server(num_threads, program.get<uint32_t>("max-scenes"));
+        server.serve(program.get("socket"));
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
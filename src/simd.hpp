@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace simd {
+
+template<typename T>
+struct Lanes {
+    typedef T type __attribute__((vector_size(4 * sizeof(T))));
+};
+
+// Four lanes of `T` in one SSE/AVX register.
+template<typename T>
+using lanes_t = typename Lanes<T>::type;
+
+// As many lanes of `T` as one vector register of the target holds, for loops
+// over packets. Wider vectors than the target has are split into scalar code.
+#ifdef __AVX__
+constexpr size_t REGISTER_BYTES = 32;
+#else
+constexpr size_t REGISTER_BYTES = 16;
+#endif
+
+template<typename T>
+struct Register {
+    typedef T type __attribute__((vector_size(REGISTER_BYTES)));
+};
+
+template<typename T>
+using register_t = typename Register<T>::type;
+
+// Whether an operation on `U` and `V` components uses the packed path.
+template<typename U, typename V>
+#ifdef RT_SIMD
+constexpr bool enabled = std::is_same_v<U, V>;
+#else
+constexpr bool enabled = false;
+#endif
+
+// Sum of the first three lanes, added in the same order as the scalar code.
+template<typename T>
+inline T sum3(lanes_t<T> v) {
+    return v[0] + v[1] + v[2];
+}
+
+// Lane indices for `__builtin_shuffle` on `lanes_t<T>`.
+template<typename T>
+using mask_t = lanes_t<std::conditional_t<sizeof(T) == 8, int64_t, int32_t>>;
+
+// (y, z, x) and (z, x, y) rotations of the first three lanes.
+template<typename T>
+inline lanes_t<T> yzx(lanes_t<T> v) { return __builtin_shuffle(v, mask_t<T>{1, 2, 0, 3}); }
+
+template<typename T>
+inline lanes_t<T> zxy(lanes_t<T> v) { return __builtin_shuffle(v, mask_t<T>{2, 0, 1, 3}); }
+
+}
+
+// Component storage shared by Vec3, Point3 and Color. The scalar backend is
+// a plain array of three. Building with -DRT_SIMD stores a GCC vector of four
+// lanes instead (the fourth is zero) so their arithmetic compiles to packed
+// instructions. Both support `elem[i]` and `elem{x, y, z}`.
+#ifdef RT_SIMD
+template<typename T>
+using vec3_storage_t = simd::lanes_t<T>;
+#else
+template<typename T>
+using vec3_storage_t = T[3];
+#endif
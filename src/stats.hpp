@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Traversal counters for finding out why a frame is slow. They are compiled
+// in only with -DRT_STATS; otherwise every RT_STAT(...) expands to nothing.
+// Each thread counts into its own `TraversalStats::local()`, and `render`
+// merges the counts of every chunk into its RenderStats.
+struct TraversalStats {
+    static constexpr size_t MAX_DEPTH = 16;     // Deeper bounces share the last bucket.
+    enum PrimIndex : size_t { SPHERE, QUAD, TRANSFORM, MEDIUM, OTHER, NUM_PRIM_TYPES };  // Same order as CompiledScene::PrimType.
+    static constexpr const char *PRIM_TYPE_NAMES[NUM_PRIM_TYPES] = { "sphere", "quad", "transform", "medium", "other" };
+
+    uint64_t rays_by_depth[MAX_DEPTH] = {};
+    uint64_t nodes_visited = 0;
+    uint64_t aabb_tests = 0;
+    uint64_t primitive_tests[NUM_PRIM_TYPES] = {};
+    uint64_t medium_boundary_queries = 0;
+    uint64_t paths_escaped = 0;         // Left the scene.
+    uint64_t paths_absorbed = 0;        // Hit a material that does not scatter.
+    uint64_t paths_depth_limited = 0;   // Cut off at the maximum depth.
+
+    static TraversalStats& local() {
+        static thread_local TraversalStats stats;
+        return stats;
+    }
+
+    static size_t depth_bucket(int32_t depth) { return std::min<size_t>(depth, MAX_DEPTH - 1); }
+
+    TraversalStats& operator+=(const TraversalStats &other) {
+        for (size_t i = 0; i < MAX_DEPTH; i++) rays_by_depth[i] += other.rays_by_depth[i];
+        for (size_t i = 0; i < NUM_PRIM_TYPES; i++) primitive_tests[i] += other.primitive_tests[i];
+        nodes_visited += other.nodes_visited;
+        aabb_tests += other.aabb_tests;
+        medium_boundary_queries += other.medium_boundary_queries;
+        paths_escaped += other.paths_escaped;
+        paths_absorbed += other.paths_absorbed;
+        paths_depth_limited += other.paths_depth_limited;
+
+        return *this;
+    }
+
+    uint64_t rays() const {
+        uint64_t total = 0;
+        for (const auto n : rays_by_depth) total += n;
+        return total;
+    }
+
+    std::string json() const {
+        std::string depths, prims;
+        for (size_t i = 0; i < MAX_DEPTH; i++) {
+            depths += std::format("{}{}", i == 0 ? "" : ", ", rays_by_depth[i]);
+        }
+        for (size_t i = 0; i < NUM_PRIM_TYPES; i++) {
+            prims += std::format("{}\"{}\": {}", i == 0 ? "" : ", ", PRIM_TYPE_NAMES[i], primitive_tests[i]);
+        }
+
+        return std::format("{{ \"rays_by_depth\": [{}], \"nodes_visited\": {}, \"aabb_tests\": {}, \"primitive_tests\": {{ {} }}, "
+            "\"medium_boundary_queries\": {}, \"paths_escaped\": {}, \"paths_absorbed\": {}, \"paths_depth_limited\": {} }}",
+            depths, nodes_visited, aabb_tests, prims, medium_boundary_queries, paths_escaped, paths_absorbed, paths_depth_limited);
+    }
+};
+
+inline std::ostream& operator<<(std::ostream &out, const TraversalStats &stats) {
+    const uint64_t rays = std::max<uint64_t>(stats.rays(), 1);
+
+    out << std::format("rays:               {}\n", stats.rays());
+    for (size_t i = 0; i < TraversalStats::MAX_DEPTH && stats.rays_by_depth[i] > 0; i++) {
+        out << std::format("  depth {:>2}{}:       {}\n", i, i + 1 == TraversalStats::MAX_DEPTH ? "+" : " ", stats.rays_by_depth[i]);
+    }
+    out << std::format("nodes visited:      {} ({:.1f}/ray)\n", stats.nodes_visited, double(stats.nodes_visited) / rays);
+    out << std::format("aabb tests:         {} ({:.1f}/ray)\n", stats.aabb_tests, double(stats.aabb_tests) / rays);
+    for (size_t i = 0; i < TraversalStats::NUM_PRIM_TYPES; i++) {
+        if (stats.primitive_tests[i] == 0) continue;
+        out << std::format("{:<10} tests:   {} ({:.1f}/ray)\n", TraversalStats::PRIM_TYPE_NAMES[i], stats.primitive_tests[i], double(stats.primitive_tests[i]) / rays);
+    }
+    out << std::format("medium queries:     {}\n", stats.medium_boundary_queries);
+    out << std::format("paths escaped:      {}\n", stats.paths_escaped);
+    out << std::format("paths absorbed:     {}\n", stats.paths_absorbed);
+    out << std::format("paths depth-capped: {}\n", stats.paths_depth_limited);
+
+    return out;
+}
+
+#ifdef RT_STATS
+#define RT_STAT(expr) (TraversalStats::local().expr)
+#else
+#define RT_STAT(expr) ((void)0)
+#endif
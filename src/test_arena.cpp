@@ -0,0 +1,74 @@
+#include "arena.hpp"
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+struct Counted {
+    Counted(int &live) : live_(live) { live_++; }
+    ~Counted() { live_--; }
+
+    int &live_;
+};
+
+void test_scope() {
+    {
+        const auto arena = std::make_shared<Arena>();
+        assert(!Arena::current());
+        {
+            ArenaScope scope(arena);
+            assert(Arena::current() == arena);
+            {
+                ArenaScope inner(nullptr);
+                assert(!Arena::current());
+            }
+            assert(Arena::current() == arena);
+        }
+        assert(!Arena::current());
+    }
+}
+
+void test_allocation() {
+    {
+        int live = 0;
+        std::weak_ptr<Arena> weak;
+        std::shared_ptr<Counted> a, b;
+        {
+            const auto arena = std::make_shared<Arena>();
+            weak = arena;
+
+            ArenaScope scope(arena);
+            a = make_arena_shared<Counted>(live);
+            b = make_arena_shared<Counted>(live);
+            assert(arena->bytes_allocated() > 0);
+        }
+
+        assert(live == 2);
+        assert(!weak.expired());
+
+        a.reset();
+        assert(live == 1);
+        assert(!weak.expired());
+
+        b.reset();
+        assert(live == 0);
+        assert(weak.expired());
+    }
+}
+
+void test_alignment() {
+    {
+        struct alignas(32) Wide { double v[4]; };
+
+        ArenaScope scope(std::make_shared<Arena>());
+        for (int i = 0; i < 8; i++) {
+            const auto w = make_arena_shared<Wide>();
+            assert(reinterpret_cast<uintptr_t>(w.get()) % 32 == 0);
+        }
+    }
+}
+
+int main() {
+    test_scope();
+    test_allocation();
+    test_alignment();
+}
@@ -7,7 +7,8 @@ void test_from_float() {
         const Color a(1.0, 0.0, 0.25);
         assert_eq(a.r_int(), static_cast<uint32_t>(255));
         assert_eq(a.g_int(), static_cast<uint32_t>(0));
-        assert_eq(a.b_int(), static_cast<uint32_t>(63));
+        // Gamma-encoded: sqrt(0.25) * 256.
+        assert_eq(a.b_int(), static_cast<uint32_t>(128));
     }
 }
 
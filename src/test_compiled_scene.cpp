@@ -0,0 +1,123 @@
+#include "bvh.hpp"
+#include "compiled_scene.hpp"
+#include "hittable_list.hpp"
+#include "instance.hpp"
+#include "material.hpp"
+#include "quad.hpp"
+#include "sphere.hpp"
+#include "test_util.hpp"
+#include <cassert>
+#include <cmath>
+#include <memory>
+
+HittableList random_scene() {
+    const auto mat_1 = std::make_shared<Lambertian>(Color(0.5, 0.5, 0.5));
+    const auto mat_2 = std::make_shared<Metal>(Color(0.8, 0.8, 0.8), 0.1);
+
+    HittableList objs;
+    for (int i = 0; i < 200; i++) {
+        const Point3<real> center(random_double(-50, 50), random_double(-50, 50), random_double(-50, 50));
+        if (i % 3 == 0) {
+            objs.add(std::make_shared<Sphere>(center, center + Vec3<real>(0, random_double(0, 2), 0), random_double(0.5, 3), mat_1));
+        } else {
+            objs.add(std::make_shared<Sphere>(center, random_double(0.5, 3), mat_2));
+        }
+    }
+
+    for (int i = 0; i < 50; i++) {
+        const Point3<real> origin(random_double(-50, 50), random_double(-50, 50), random_double(-50, 50));
+        objs.add(std::make_shared<Quad>(origin, Vec3<real>::random(-5, 5), Vec3<real>::random(-5, 5), mat_1));
+    }
+
+    HittableList cluster;
+    for (int i = 0; i < 20; i++) {
+        cluster.add(std::make_shared<Box>(Point3<real>(Vec3<real>::random(0, 10)), Point3<real>(Vec3<real>::random(0, 10)), mat_2));
+    }
+    const auto cluster_bvh = std::make_shared<BVHNode>(cluster);
+
+    objs.add(std::make_shared<Translate>(std::make_shared<RotateY>(cluster_bvh, 30), Vec3<real>(20, 0, -20)));
+    objs.add(std::make_shared<Instance>(cluster_bvh, Transform(Vec3<real>(-20, 5, 10), Vec3<real>(10, 45, 0), Vec3<real>(2, 1, 2))));
+
+    return objs;
+}
+
+void test_matches_bvh() {
+    {
+        const HittableList objs = random_scene();
+        const BVHNode reference(objs);
+        const CompiledScene compiled(objs.objs);
+
+        int hits = 0;
+        for (int i = 0; i < 20000; i++) {
+            const Ray<real> ray(Point3<real>(Vec3<real>::random(-60, 60)), Vec3<real>::random(-1, 1), random_double());
+
+            HitRecord expected, actual;
+            const bool expected_hit = reference.hit(ray, Interval(0.001, infinity), expected);
+            const bool actual_hit = compiled.hit(ray, Interval(0.001, infinity), actual);
+
+            assert(expected_hit == actual_hit);
+            if (!expected_hit) continue;
+
+            hits++;
+            assert(std::fabs(expected.t - actual.t) < tolerance);
+            assert((expected.normal - actual.normal).length() < 1e-6);
+            assert(expected.front_face == actual.front_face);
+            assert(expected.mat == actual.mat);
+        }
+
+        assert(hits > 0);
+    }
+}
+
+void test_packet_matches_single() {
+    {
+        const HittableList objs = random_scene();
+        const CompiledScene compiled(objs.objs);
+
+        int hits = 0;
+        for (int i = 0; i < 2000; i++) {
+            // A pinhole-camera-like bundle: shared origin, nearby directions.
+            const Point3<real> origin(Vec3<real>::random(-60, 60));
+            const Vec3<real> dir = Vec3<real>::random(-1, 1);
+            const size_t count = 1 + i % CompiledScene::PACKET_SIZE;
+
+            Ray<real> rays[CompiledScene::PACKET_SIZE];
+            for (size_t n = 0; n < count; n++) {
+                rays[n] = Ray<real>(origin, dir + 0.05 * Vec3<real>::random(-1, 1), random_double());
+            }
+
+            HitRecord recs[CompiledScene::PACKET_SIZE];
+            bool packet_hits[CompiledScene::PACKET_SIZE];
+            compiled.hit_packet(rays, count, Interval(0.001, infinity), recs, packet_hits);
+
+            for (size_t n = 0; n < count; n++) {
+                HitRecord expected;
+                const bool expected_hit = compiled.hit(rays[n], Interval(0.001, infinity), expected);
+
+                assert(expected_hit == packet_hits[n]);
+                if (!expected_hit) continue;
+
+                hits++;
+                assert(expected.t == recs[n].t);
+                assert((expected.normal - recs[n].normal).length() < 1e-6);
+                assert(expected.mat == recs[n].mat);
+            }
+        }
+
+        assert(hits > 0);
+    }
+}
+
+void test_empty() {
+    {
+        const CompiledScene compiled(std::vector<std::shared_ptr<Hittable>>{});
+        HitRecord rec;
+        assert(!compiled.hit(Ray<real>(Point3<real>(), Vec3<real>(1, 0, 0)), Interval(0.001, infinity), rec));
+    }
+}
+
+int main() {
+    test_matches_bvh();
+    test_packet_matches_single();
+    test_empty();
+}
@@ -0,0 +1,47 @@
+#include "cpu_count.hpp"
+#include <cassert>
+
+void test_cgroup_v1() {
+    const std::string cgroup = "4:memory:/pod\n2:cpuacct:/\n1:cpu,cpuacct:/kubepods/pod1\n0::/\n";
+    const std::string mountinfo =
+        "32 24 0:28 / /sys/fs/cgroup rw,relatime - tmpfs tmpfs rw,mode=755\n"
+        "33 32 0:29 / /sys/fs/cgroup/cpu,cpuacct rw,relatime shared:9 - cgroup cgroup rw,cpu,cpuacct\n"
+        "36 32 0:32 / /sys/fs/cgroup/memory rw,relatime - cgroup cgroup rw,memory\n";
+
+    const auto dirs = CpuCount::cgroup_dirs(cgroup, mountinfo);
+    assert(dirs.size() == 1);
+    assert(dirs[0].version == 1);
+    assert(dirs[0].path == "/sys/fs/cgroup/cpu,cpuacct/kubepods/pod1");
+    assert(dirs[0].mount_point == "/sys/fs/cgroup/cpu,cpuacct");
+}
+
+void test_cgroup_v2_namespace() {
+    // The container sees its own cgroup mounted at the root.
+    const std::string cgroup = "0::/\n";
+    const std::string mountinfo = "30 23 0:26 /kubepods/pod1/c1 /sys/fs/cgroup ro,nosuid - cgroup2 cgroup rw\n";
+
+    const auto dirs = CpuCount::cgroup_dirs(cgroup, mountinfo);
+    assert(dirs.size() == 1);
+    assert(dirs[0].version == 2);
+    assert(dirs[0].path == "/sys/fs/cgroup");
+}
+
+void test_quota() {
+    assert(!CpuCount::quota_cpus(-1, 100000));
+    assert(CpuCount::quota_cpus(1600000, 100000) == 16u);
+    assert(CpuCount::quota_cpus(150000, 100000) == 2u);
+    assert(CpuCount::quota_cpus(10000, 100000) == 1u);
+}
+
+void test_detect() {
+    const CpuCount &cpus = CpuCount::get();
+    assert(cpus.count >= 1 && cpus.count <= std::max(std::thread::hardware_concurrency(), 1u));
+    assert(!cpus.source.empty());
+}
+
+int main(void) {
+    test_cgroup_v1();
+    test_cgroup_v2_namespace();
+    test_quota();
+    test_detect();
+}
@@ -0,0 +1,30 @@
+#include "hittable.hpp"
+#include "material.hpp"
+#include "quad.hpp"
+#include <cassert>
+#include <cmath>
+#include <memory>
+
+void test_rotate_y_bbox() {
+    {
+        // Every corner of the rotated box lies inside its bounding box.
+        const Point3<real> a(1, 2, 3), b(4, 6, 5);
+        const auto mat = std::make_shared<Lambertian>(Color(0.5, 0.5, 0.5));
+        const RotateY rotated(std::make_shared<Box>(a, b, mat), 30);
+        const BBox3 bbox = rotated.bounding_box();
+
+        const auto inside = [](const Interval &interval, real v) { return interval.min - 1e-4 <= v && v <= interval.max + 1e-4; };
+        const real theta = degrees_to_radians(30);
+        for (int i = 0; i < 8; i++) {
+            const real x = i & 1 ? b.x() : a.x(), y = i & 2 ? b.y() : a.y(), z = i & 4 ? b.z() : a.z();
+
+            assert(inside(bbox.x, std::cos(theta) * x + std::sin(theta) * z));
+            assert(inside(bbox.y, y));
+            assert(inside(bbox.z, -std::sin(theta) * x + std::cos(theta) * z));
+        }
+    }
+}
+
+int main() {
+    test_rotate_y_bbox();
+}
@@ -0,0 +1,73 @@
+#include "image_metrics.hpp"
+#include <cassert>
+#include <sstream>
+
+static Image gradient(int32_t width, int32_t height) {
+    Image img(width, height);
+    for (int32_t i = 0; i < height; i++) {
+        for (int32_t j = 0; j < width; j++) {
+            img.pixels_[i][j] = Color(real(j) / width, real(i) / height, real(0.25));
+        }
+    }
+    return img;
+}
+
+void test_identical() {
+    const Image img = gradient(16, 8);
+    const ImageError err = compare_images(img, img);
+    assert(err.mse == 0);
+    assert(err.relmse == 0);
+    assert(err.flip == 0);
+    assert(err.psnr == infinity);
+}
+
+void test_ordering() {
+    const Image ref = gradient(16, 8);
+    Image small = ref, large = ref;
+    small.pixels_[4][4] = Color(0.5, 0.5, 0.5);
+    large.pixels_[4][4] = Color(1.0, 1.0, 1.0);
+    large.pixels_[5][5] = Color(1.0, 1.0, 1.0);
+
+    const ImageError a = compare_images(ref, small), b = compare_images(ref, large);
+    assert(0 < a.mse && a.mse < b.mse);
+    assert(0 < a.flip && a.flip < b.flip && b.flip <= 1);
+}
+
+void test_linear_keeps_hdr_error() {
+    Image ref = gradient(16, 8), img = ref;
+    ref.pixels_[2][3] = Color(15.0, 15.0, 15.0);
+    img.pixels_[2][3] = Color(5.0, 5.0, 5.0);
+
+    // Both clamp to white on display, but not in linear values.
+    assert(compare_images(to_display(ref), to_display(img)).mse == 0);
+    const ImageError err = compare_images(ref, img, DEFAULT_PIXELS_PER_DEGREE, PixelSpace::Linear);
+    assert(err.max == 10);
+    assert(err.mse > 0 && err.relmse > 0);
+    assert(err.flip == 0);
+}
+
+void test_pfm_round_trip() {
+    Image img = gradient(5, 3);
+    img.pixels_[1][2] = Color(4.0, 0.0, 1e-3);
+
+    std::stringstream buffer;
+    img.write_pfm(buffer);
+    Image read;
+    read.read_pfm(buffer);
+    assert(buffer);
+    assert(read.width_ == 5 && read.height_ == 3);
+    for (int32_t i = 0; i < 3; i++) {
+        for (int32_t j = 0; j < 5; j++) {
+            for (int c = 0; c < 3; c++) {
+                assert(read.pixels_[i][j].elem[c] == static_cast<float>(img.pixels_[i][j].elem[c]));
+            }
+        }
+    }
+}
+
+int main(void) {
+    test_identical();
+    test_ordering();
+    test_linear_keeps_hdr_error();
+    test_pfm_round_trip();
+}
@@ -0,0 +1,56 @@
+#include "numa.hpp"
+#include <cassert>
+#include <stdexcept>
+
+void test_parse_cpu_list() {
+    {
+        const std::vector<uint32_t> expected = { 0, 1, 2, 3, 8, 10, 11 };
+        assert(Numa::parse_cpu_list("0-3,8,10-11") == expected);
+        // As read from sysfs.
+        assert(Numa::parse_cpu_list("0-3,8,10-11\n") == expected);
+    }
+
+    {
+        assert(Numa::parse_cpu_list("0") == std::vector<uint32_t>{ 0 });
+        assert(Numa::parse_cpu_list("5\n") == std::vector<uint32_t>{ 5 });
+        assert(Numa::parse_cpu_list("7-7") == std::vector<uint32_t>{ 7 });
+        assert(Numa::parse_cpu_list("").empty());
+    }
+}
+
+void test_on_each_node() {
+    {
+        // Every node's result comes from a thread pinned to it.
+        const auto nodes = Numa::on_each_node([] { return Numa::current_node(); });
+        assert(nodes.size() == Numa::num_nodes());
+        for (size_t node = 0; node < nodes.size(); node++) {
+            assert(nodes[node] == node);
+        }
+    }
+
+    {
+        bool threw = false;
+        try {
+            Numa::on_each_node([]() -> int { throw std::runtime_error("failed"); });
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        assert(threw);
+    }
+}
+
+void test_nodes() {
+    {
+        // Without NUMA information the machine is one node.
+        assert(Numa::num_nodes() >= 1);
+        for (const auto &cpus : Numa::nodes()) {
+            assert(!cpus.empty());
+        }
+    }
+}
+
+int main(void) {
+    test_parse_cpu_list();
+    test_on_each_node();
+    test_nodes();
+}
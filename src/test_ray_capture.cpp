@@ -0,0 +1,82 @@
+#include "ray_capture.hpp"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+const std::string FILE_NAME = "test_ray_capture.rays";
+
+void assert_rejected() {
+    bool threw = false;
+    try {
+        RayCapture::read(FILE_NAME);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_round_trip_and_corrupt_count() {
+    RayCapture::start();
+    {
+        RayCapture::Chunk chunk({ 0, 0, 0 });
+        for (int i = 0; i < 10; i++) {
+            RayCapture::record(Ray<real>(Point3<real>(i, 0, 0), Vec3<real>(0, 1, 0), 0), Interval(0.001, infinity), i);
+        }
+    }
+    assert(RayCapture::write(FILE_NAME) == 10);
+
+    const auto rays = RayCapture::read(FILE_NAME);
+    assert(rays.size() == 10);
+    assert(rays[3].origin[0] == 3 && rays[3].depth == 3);
+
+    std::string bytes;
+    {
+        std::ifstream in(FILE_NAME, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), {});
+    }
+
+    // A count larger than the file holds fails before allocating for it.
+    for (const uint64_t count : { uint64_t(11), uint64_t(1) << 60, ~uint64_t(0) }) {
+        RayCapture::Header header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        header.count = count;
+        std::string corrupt = bytes;
+        std::memcpy(corrupt.data(), &header, sizeof(header));
+        std::ofstream(FILE_NAME, std::ios::binary) << corrupt;
+        assert_rejected();
+    }
+
+    std::ofstream(FILE_NAME, std::ios::binary) << bytes.substr(0, bytes.size() - 1);
+    assert_rejected();
+
+    std::remove(FILE_NAME.c_str());
+}
+
+void test_chunk_order() {
+    RayCapture::start();
+
+    // Written by chunk, then first row, then first sample block, whatever
+    // their size.
+    const RayCapture::Key keys[] = { { 1, 0, 0 }, { 0, 40000, 0 }, { 0, 0, 70000 }, { 0, 0, 0 } };
+    for (int i = 0; i < 4; i++) {
+        RayCapture::Chunk chunk(keys[i]);
+        RayCapture::record(Ray<real>(Point3<real>(), Vec3<real>(0, 1, 0), 0), Interval(0.001, infinity), i);
+    }
+    RayCapture::write(FILE_NAME);
+
+    const auto rays = RayCapture::read(FILE_NAME);
+    const uint32_t expected[] = { 3, 2, 1, 0 };
+    assert(rays.size() >= 4);
+    for (int i = 0; i < 4; i++) {
+        assert(rays[rays.size() - 4 + i].depth == expected[i]);
+    }
+
+    std::remove(FILE_NAME.c_str());
+}
+
+int main(void) {
+    test_round_trip_and_corrupt_count();
+    test_chunk_order();
+}
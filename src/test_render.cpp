@@ -1,6 +1,306 @@
+#include "compiled_scene.hpp"
+#include "hittable_list.hpp"
+#include "material.hpp"
+#include "quad.hpp"
+#include "render.hpp"
+#include "sphere.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
-#include <iostream>
+// A small Cornell box: an open box of diffuse walls lit from the ceiling.
+HittableList box_objects() {
+    const auto red = std::make_shared<Lambertian>(Color(0.65, 0.05, 0.05));
+    const auto white = std::make_shared<Lambertian>(Color(0.73, 0.73, 0.73));
+    const auto green = std::make_shared<Lambertian>(Color(0.12, 0.45, 0.15));
+    const auto light = std::make_shared<DiffuseLight>(Color(15.0, 15.0, 15.0));
+    const std::shared_ptr<Material> glass = std::make_shared<Dielectric>(1.5);
+
+    HittableList objs;
+    objs.add(std::make_shared<Quad>(Point3<real>(555, 0, 0), Vec3<real>(0, 555, 0), Vec3<real>(0, 0, 555), green));
+    objs.add(std::make_shared<Quad>(Point3<real>(0, 0, 0), Vec3<real>(0, 555, 0), Vec3<real>(0, 0, 555), red));
+    objs.add(std::make_shared<Quad>(Point3<real>(343, 554, 332), Vec3<real>(-130, 0, 0), Vec3<real>(0, 0, -105), light));
+    objs.add(std::make_shared<Quad>(Point3<real>(0, 0, 0), Vec3<real>(555, 0, 0), Vec3<real>(0, 0, 555), white));
+    objs.add(std::make_shared<Quad>(Point3<real>(555, 555, 555), Vec3<real>(-555, 0, 0), Vec3<real>(0, 0, -555), white));
+    objs.add(std::make_shared<Quad>(Point3<real>(0, 0, 555), Vec3<real>(555, 0, 0), Vec3<real>(0, 555, 0), white));
+    objs.add(std::make_shared<Sphere>(Point3<real>(190, 90, 190), 90, glass));
+
+    return objs;
+}
+
+// Pixels the render never wrote keep a negative color.
+Image render_box(const CompiledScene &scene, RenderSettings rs, uint32_t num_threads, int32_t width = 16, int32_t height = 16) {
+    Image img(width, height);
+    for (auto &row : img.pixels_) {
+        std::fill(row.begin(), row.end(), Color(-1.0, -1.0, -1.0));
+    }
+    CameraBuilder cb;
+    cb.vfov_ = 40;
+    cb.lookfrom_ = Point3<real>(278, 278, -800);
+    cb.lookat_ = Point3<real>(278, 278, 0);
+
+    rs.num_threads = num_threads;
+    render(img, cb.build(img), scene, rs, nullptr, [](const RenderProgress &) {});
+
+    return img;
+}
+
+// More samples than RenderTaskGenerator::SAMPLE_BLOCK split every band into
+// blocks, which more threads render on different workers and in another
+// order, and split chunks differently. The image must not change.
+void test_independent_of_threads() {
+    const HittableList objs = box_objects();
+    const CompiledScene scene(objs.objs);
+
+    RenderSettings rs(RenderTaskGenerator::SAMPLE_BLOCK + 44, 8);
+    rs.chunk_width_ = 4;
+    rs.chunk_height_ = 4;
+    rs.seed_ = 7;
+
+    for (const bool packets : { true, false }) {
+        rs.packets_ = packets;
+        const Image one = render_box(scene, rs, 1);
+        const Image many = render_box(scene, rs, 8);
+
+        bool lit = false;
+        for (int32_t i = 0; i < one.height_; i++) {
+            for (int32_t j = 0; j < one.width_; j++) {
+                const Color &a = one.pixels_[i][j], &b = many.pixels_[i][j];
+                assert(a.r() == b.r() && a.g() == b.g() && a.b() == b.b());
+                lit = lit || a.r() > 0;
+            }
+        }
+        assert(lit);
+    }
+}
+
+Color mean(const Image &img) {
+    Color sum;
+    for (const auto &row : img.pixels_) {
+        for (const Color &c : row) {
+            sum += c;
+        }
+    }
+
+    return sum * (1.0 / (img.width_ * img.height_));
+}
+
+// The wavefront integrator estimates the same radiance as the recursive one,
+// and like it doesn't depend on which thread renders which chunk.
+void test_wavefront() {
+    const HittableList objs = box_objects();
+    const CompiledScene scene(objs.objs);
+
+    RenderSettings rs(256, 8);
+    rs.chunk_width_ = 4;
+    rs.chunk_height_ = 4;
+    rs.seed_ = 7;
+
+    const Color recursive = mean(render_box(scene, rs, 8));
+
+    rs.integrator_ = Integrator::Wavefront;
+    const Image one = render_box(scene, rs, 1);
+    const Image many = render_box(scene, rs, 8);
+    for (int32_t i = 0; i < one.height_; i++) {
+        for (int32_t j = 0; j < one.width_; j++) {
+            assert(one.pixels_[i][j] == many.pixels_[i][j]);
+        }
+    }
+
+    const Color wavefront = mean(one);
+    const auto near = [](real a, real b) { return b > 0 && std::abs(a - b) < 0.1 * b; };
+    assert(near(wavefront.r(), recursive.r()) && near(wavefront.g(), recursive.g()) && near(wavefront.b(), recursive.b()));
+}
+
+// Chunks that don't divide the image are clipped at its right and bottom
+// edges, yet cover every pixel once.
+void test_edge_chunks() {
+    const HittableList objs = box_objects();
+    const CompiledScene scene(objs.objs);
+
+    RenderSettings rs(8, 8);
+    rs.chunk_width_ = 4;
+    rs.chunk_height_ = 4;
+    rs.seed_ = 7;
+
+    for (const Integrator integrator : { Integrator::Recursive, Integrator::Wavefront }) {
+        rs.integrator_ = integrator;
+        const Image one = render_box(scene, rs, 1, 17, 13);
+        const Image many = render_box(scene, rs, 8, 17, 13);
+        for (int32_t i = 0; i < one.height_; i++) {
+            for (int32_t j = 0; j < one.width_; j++) {
+                const Color &c = one.pixels_[i][j];
+                assert(c.r() >= 0 && c.g() >= 0 && c.b() >= 0);
+                assert(c == many.pixels_[i][j]);
+            }
+        }
+    }
+}
+
+void test_fit_chunks() {
+    for (const auto &[width, height] : { std::pair(1920, 1080), std::pair(641, 479), std::pair(17, 13), std::pair(3, 1) }) {
+        const Image img(width, height);
+        for (const uint32_t threads : { 1u, 8u, 64u }) {
+            RenderSettings rs;
+            rs.num_threads = threads;
+            fit_chunks(rs, img);
+
+            assert(rs.chunk_width_ > 0 && rs.chunk_width_ <= width);
+            assert(rs.chunk_height_ > 0 && rs.chunk_height_ <= height);
+            assert(rs.chunk_width_ % 4 == 0 || rs.chunk_width_ == width);
+            assert(rs.chunk_height_ % RenderTaskGenerator::BAND_HEIGHT == 0 || rs.chunk_height_ == height);
+        }
+    }
+
+    {
+        // Sizes that are set are only clamped to the image.
+        const Image img(100, 50);
+        RenderSettings rs;
+        rs.chunk_width_ = 7;
+        rs.chunk_height_ = 80;
+        fit_chunks(rs, img);
+
+        assert(rs.chunk_width_ == 7);
+        assert(rs.chunk_height_ == 50);
+    }
+
+    {
+        const Image img(1, 1);
+        RenderSettings rs;
+        fit_chunks(rs, img);
+
+        assert(rs.chunk_width_ == 1 && rs.chunk_height_ == 1);
+    }
+}
+
+// The progress callback sees the fraction done grow to exactly 1.
+void test_progress() {
+    const HittableList objs = box_objects();
+    const CompiledScene scene(objs.objs);
+
+    Image img(96, 96);
+    CameraBuilder cb;
+    cb.lookfrom_ = Point3<real>(278, 278, -800);
+    cb.lookat_ = Point3<real>(278, 278, 0);
+
+    // Long enough for a few progress reports before the last one.
+    RenderSettings rs(256, 8);
+    rs.num_threads = 2;
+    fit_chunks(rs, img);
+
+    std::vector<double> fractions;
+    render(img, cb.build(img), scene, rs, nullptr, [&](const RenderProgress &progress) {
+        assert(progress.seconds >= 0);
+        fractions.push_back(progress.fraction);
+    });
+
+    assert(!fractions.empty());
+    assert(fractions.back() == 1.0);
+    assert(std::is_sorted(fractions.begin(), fractions.end()));
+    assert(fractions.front() >= 0);
+}
+
+// Pinned workers take chunks in another order. The image must not change.
+void test_pinned() {
+    const HittableList objs = box_objects();
+    const CompiledScene scene(objs.objs);
+
+    RenderSettings rs(16, 8);
+    rs.chunk_width_ = 4;
+    rs.chunk_height_ = 4;
+    rs.seed_ = 3;
+
+    const Image unpinned = render_box(scene, rs, 4);
+    rs.pin_threads_ = true;
+    const Image pinned = render_box(scene, rs, 4);
+
+    assert(pinned.pixels_ == unpinned.pixels_);
+}
+
+// With a range per NUMA node, a worker drains its own range and then steals
+// from the others. Every chunk must be rendered exactly once: all pixels
+// written, and no rows counted twice.
+void test_ranges() {
+    const HittableList objs = box_objects();
+    const CompiledScene scene(objs.objs);
+
+    CameraBuilder cb;
+    cb.lookfrom_ = Point3<real>(278, 278, -800);
+    cb.lookat_ = Point3<real>(278, 278, 0);
+
+    RenderSettings rs(4, 4);
+    rs.chunk_width_ = 4;
+    rs.chunk_height_ = 4;
+
+    Image reference(18, 14);
+    const Camera cam = cb.build(reference);
+    {
+        RenderTaskGenerator gen(reference, cam, { &scene }, rs, 1);
+        while (auto task = gen.next()) (*task)();
+    }
+
+    // With more threads than chunks the last ones are split as well.
+    for (const uint32_t num_threads : { 1, 64 }) {
+        for (const int32_t num_ranges : { 2, 3, 5 }) {
+            rs.num_threads = num_threads;
+            Image img(18, 14);
+            for (auto &row : img.pixels_) {
+                std::fill(row.begin(), row.end(), Color(-1.0, -1.0, -1.0));
+            }
+
+            RenderTaskGenerator gen(img, cam, { &scene }, rs, num_ranges);
+            while (auto task = gen.next()) (*task)();
+
+            assert(!gen.has_next());
+            assert(gen.progress(0) == 1.0);
+            assert(img.pixels_ == reference.pixels_);
+        }
+    }
+}
+
+// A pool's workers, not `rs.num_threads`, decide how far the last chunk is
+// split: a single chunk becomes one traced tile per piece.
+void test_pool_splits() {
+    const HittableList objs = box_objects();
+    const CompiledScene scene(objs.objs);
+
+    Image img(8, 8);
+    CameraBuilder cb;
+    cb.lookfrom_ = Point3<real>(278, 278, -800);
+    cb.lookat_ = Point3<real>(278, 278, 0);
+
+    RenderSettings rs(4, 4);
+    rs.chunk_width_ = 8;
+    rs.chunk_height_ = 8;
+    rs.num_threads = 1;
+
+    Trace::start();
+    PersistentThreadPool pool(4);
+    render(img, cb.build(img), scene, rs, pool);
+
+    std::ostringstream trace;
+    Trace::write(trace);
+    const std::string events = trace.str();
+    size_t tiles = 0;
+    for (size_t at = events.find("\"name\": \"tile\""); at != std::string::npos; at = events.find("\"name\": \"tile\"", at + 1)) {
+        tiles++;
+    }
+    assert(tiles >= pool.num_threads);
+}
 
 int main(void) {
-    std::cout << "Hello\n";
+    test_independent_of_threads();
+    test_wavefront();
+    test_edge_chunks();
+    test_fit_chunks();
+    test_progress();
+    test_pinned();
+    test_ranges();
+    test_pool_splits();
 }
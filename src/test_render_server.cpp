@@ -0,0 +1,130 @@
+#include "render_server.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+const std::string OUTPUT = "test_render_server.ppm";
+
+const std::string SCENE = R"(textures: []
+materials:
+  - {name: Red, type: lambertian, texture: {type: solid_color, color: [1.0, 0.2, 0.2]}}
+objects:
+  - {type: sphere, origin: {origin: [0, 0, -1], direction: [0, 0, 1]}, radius: 0.5, material: Red}
+)";
+
+// `job` must be rejected before its scene is loaded or anything rendered.
+// The scene doesn't exist, so only the validation can produce the "Invalid"
+// error, and nothing may be written.
+void assert_rejected(RenderServer &server, const RenderJob &job) {
+    std::string message;
+    try {
+        server.run(job);
+    } catch (const std::runtime_error &err) {
+        message = err.what();
+    }
+    assert(message.starts_with("Invalid"));
+    assert(!std::filesystem::exists(OUTPUT));
+}
+
+void test_rejects_invalid_jobs() {
+    RenderServer server(1, 1);
+
+    RenderJob job;
+    job.scene = "test_render_server_missing.yaml";
+    job.width = 8;
+    job.height = 8;
+    job.output = OUTPUT;
+
+    RenderJob empty = job;
+    empty.width = 0;
+    assert_rejected(server, empty);
+
+    RenderJob no_samples = job;
+    no_samples.rs.samples_per_pixel_ = 0;
+    assert_rejected(server, no_samples);
+
+    RenderJob negative_chunks = job;
+    negative_chunks.rs.chunk_width_ = -4;
+    assert_rejected(server, negative_chunks);
+
+    // A valid job gets as far as loading the scene.
+    std::string message;
+    try {
+        server.run(job);
+    } catch (const std::exception &err) {
+        message = err.what();
+    }
+    assert(!message.empty() && !message.starts_with("Invalid"));
+}
+
+void test_keeps_other_files() {
+    const std::string path = "test_render_server.txt";
+    std::ofstream(path) << "precious\n";
+
+    RenderServer server(1, 1);
+    bool threw = false;
+    try {
+        server.serve(path);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::ifstream file(path);
+    std::string contents;
+    std::getline(file, contents);
+    assert(contents == "precious");
+
+    std::remove(path.c_str());
+}
+
+// Renders `scene` and returns whether the server had it loaded already.
+bool run_cached(RenderServer &server, const std::string &scene) {
+    RenderJob job;
+    job.scene = scene;
+    job.width = 8;
+    job.height = 8;
+    job.rs.set_samples_per_pixel(2);
+    job.rs.max_depth_ = 4;
+    job.output = OUTPUT;
+
+    const std::string reply = server.run(job);
+    assert(reply.starts_with("ok: "));
+    assert(std::filesystem::exists(OUTPUT));
+    std::remove(OUTPUT.c_str());
+
+    return reply.contains(" scene cached ");
+}
+
+void test_scene_cache() {
+    const std::string first = "test_render_server_1.yaml", second = "test_render_server_2.yaml";
+    std::ofstream(first) << SCENE;
+    std::ofstream(second) << SCENE;
+
+    RenderServer server(2, 1);
+    assert(!run_cached(server, first));
+    assert(run_cached(server, first));
+
+    // Edited since it was loaded.
+    std::filesystem::last_write_time(first, std::filesystem::last_write_time(first) + std::chrono::seconds(1));
+    assert(!run_cached(server, first));
+    assert(run_cached(server, first));
+
+    // Only one scene is kept, so loading the second evicts the first.
+    assert(!run_cached(server, second));
+    assert(run_cached(server, second));
+    assert(!run_cached(server, first));
+
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+}
+
+int main(void) {
+    test_rejects_invalid_jobs();
+    test_keeps_other_files();
+    test_scene_cache();
+}
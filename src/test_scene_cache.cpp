@@ -0,0 +1,106 @@
+#include "scene_cache.hpp"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+const std::filesystem::path DIR = std::filesystem::temp_directory_path() / "test_scene_cache";
+
+const std::string SCENE = R"(textures: []
+materials:
+  - {name: Red, type: lambertian, texture: {type: solid_color, color: [1.0, 0.2, 0.2]}}
+  - {name: Light, type: diffuse-light, texture: {type: solid_color, color: [4.0, 4.0, 4.0]}}
+objects:
+  - {type: sphere, origin: {origin: [0, -1000, 0], direction: [0, 0, 1]}, radius: 1000, material: Red}
+  - {type: sphere, origin: {origin: [0, 1, 0], direction: [0, 0, 1]}, radius: 1, material: Red}
+  - {type: quad, origin: [-2, 5, -2], u: [4, 0, 0], v: [0, 0, 4], material: Light}
+)";
+
+void write_file(const std::filesystem::path &path, const std::string &contents) {
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    assert(file);
+}
+
+void assert_same(const SceneFile::Loaded &a, const SceneFile::Loaded &b) {
+    assert(a.scene->nodes().size() == b.scene->nodes().size());
+    assert(a.scene->spheres().size() == b.scene->spheres().size());
+    assert(a.scene->quads().size() == b.scene->quads().size());
+}
+
+void test_key() {
+    {
+        assert(SceneCache::key(SCENE) == SceneCache::key(SCENE));
+        assert(SceneCache::key(SCENE) != SceneCache::key(SCENE + "\n"));
+        assert(SceneCache::key("") != SceneCache::key(std::string(1, '\0')));
+    }
+}
+
+void test_load() {
+    std::filesystem::remove_all(DIR);
+    std::filesystem::create_directories(DIR);
+
+    const auto scene = (DIR / "scene.yaml").string();
+    write_file(scene, SCENE);
+
+    const SceneCache cache(DIR / "cache");
+    const auto entry = DIR / "cache" / std::format("{:016x}.rtc", SceneCache::key(SCENE));
+
+    // A miss compiles the scene and stores it.
+    const auto built = cache.load(scene);
+    assert(built.scene->spheres().size() == 2);
+    assert(built.scene->quads().size() == 1);
+    assert(std::filesystem::exists(entry));
+    const auto size = std::filesystem::file_size(entry);
+    const auto written = std::filesystem::last_write_time(entry);
+
+    // A hit maps the entry without rewriting it.
+    const auto cached = cache.load(scene);
+    assert_same(cached, built);
+    assert(std::filesystem::last_write_time(entry) == written);
+
+    // Broken entries are rebuilt rather than failing the load.
+    std::filesystem::resize_file(entry, size / 2);
+    assert_same(cache.load(scene), built);
+    assert(std::filesystem::file_size(entry) == size);
+
+    write_file(entry, "not a scene");
+    assert_same(cache.load(scene), built);
+    assert(std::filesystem::file_size(entry) == size);
+
+    std::filesystem::remove_all(DIR);
+}
+
+void test_concurrent_misses() {
+    std::filesystem::remove_all(DIR);
+    std::filesystem::create_directories(DIR);
+
+    const auto scene = (DIR / "scene.yaml").string();
+    write_file(scene, SCENE);
+
+    // Every thread misses and writes the entry through its own temporary
+    // file. The entry left behind must be whole, with no temporaries.
+    const SceneCache cache(DIR / "cache");
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] { assert(cache.load(scene).scene->spheres().size() == 2); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (const auto &entry : std::filesystem::directory_iterator(DIR / "cache")) {
+        assert(entry.path().extension() == ".rtc");
+        assert(SceneFile::load(entry.path()).scene->spheres().size() == 2);
+    }
+
+    std::filesystem::remove_all(DIR);
+}
+
+int main(void) {
+    test_key();
+    test_load();
+    test_concurrent_misses();
+}
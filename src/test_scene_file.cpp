@@ -0,0 +1,184 @@
+#include "compiled_scene.hpp"
+#include "hittable_list.hpp"
+#include "material.hpp"
+#include "quad.hpp"
+#include "scene_file.hpp"
+#include "sphere.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+const std::string FILE_NAME = "test_scene_file.rtc";
+
+HittableList scene_objects() {
+    const auto checker = std::make_shared<CheckerTexture>(0.5, Color(0.2, 0.3, 0.1), Color(0.9, 0.9, 0.9));
+    const auto ground = std::make_shared<Lambertian>(checker);
+    const std::shared_ptr<Material> metal = std::make_shared<Metal>(Color(0.8, 0.6, 0.2), 0.3);
+    const std::shared_ptr<Material> glass = std::make_shared<Dielectric>(1.5);
+    const auto light = std::make_shared<DiffuseLight>(Color(4, 4, 4));
+
+    HittableList objs;
+    objs.add(std::make_shared<Sphere>(Point3<real>(0, -1000, 0), 1000, ground));
+    for (int i = 0; i < 20; i++) {
+        const Point3<real> center(random_double(-10, 10), 0.5, random_double(-10, 10));
+        objs.add(std::make_shared<Sphere>(center, 0.5, i % 2 ? metal : glass));
+    }
+    objs.add(std::make_shared<Quad>(Point3<real>(-2, 5, -2), Vec3<real>(4, 0, 0), Vec3<real>(0, 0, 4), light));
+    objs.add(std::make_shared<Box>(Point3<real>(3, 0, 3), Point3<real>(5, 2, 5), glass));
+
+    return objs;
+}
+
+void test_round_trip() {
+    {
+        const HittableList objs = scene_objects();
+        const CompiledScene compiled(objs.objs);
+
+        CameraBuilder cb;
+        cb.vfov_ = 35;
+        cb.lookfrom_ = Point3<real>(13, 2, 3);
+        SceneFile::write(FILE_NAME, compiled, cb);
+
+        assert(SceneFile::is_scene_file(FILE_NAME));
+        const auto loaded = SceneFile::load(FILE_NAME);
+        assert(loaded.cb.vfov_ == 35);
+        assert(loaded.cb.lookfrom_.x() == 13);
+        assert(loaded.scene->nodes().size() == compiled.nodes().size());
+        assert(loaded.scene->spheres().size() == compiled.spheres().size());
+
+        for (int i = 0; i < 5000; i++) {
+            const Ray<real> ray(Point3<real>(Vec3<real>::random(-15, 15)), Vec3<real>::random(-1, 1), random_double());
+
+            HitRecord expected, actual;
+            const bool expected_hit = compiled.hit(ray, Interval(0.001, infinity), expected);
+            const bool actual_hit = loaded.scene->hit(ray, Interval(0.001, infinity), actual);
+
+            assert(expected_hit == actual_hit);
+            if (!expected_hit) continue;
+
+            assert(expected.t == actual.t);
+            assert(expected.mat->kind() == actual.mat->kind());
+        }
+    }
+
+    std::remove(FILE_NAME.c_str());
+}
+
+void test_copy() {
+    {
+        const HittableList objs = scene_objects();
+        const CompiledScene compiled(objs.objs);
+        SceneFile::write(FILE_NAME, compiled, CameraBuilder());
+
+        const auto loaded = SceneFile::load(FILE_NAME, true);
+
+        // Truncating the file would fault a scene still reading the mapping.
+        std::ofstream(FILE_NAME, std::ios::trunc).close();
+
+        assert(loaded.scene->nodes().size() == compiled.nodes().size());
+        assert(std::memcmp(loaded.scene->nodes().data(), compiled.nodes().data(), compiled.nodes().size_bytes()) == 0);
+        for (int i = 0; i < 1000; i++) {
+            const Ray<real> ray(Point3<real>(Vec3<real>::random(-15, 15)), Vec3<real>::random(-1, 1), random_double());
+
+            HitRecord expected, actual;
+            const bool expected_hit = compiled.hit(ray, Interval(0.001, infinity), expected);
+            const bool actual_hit = loaded.scene->hit(ray, Interval(0.001, infinity), actual);
+
+            assert(expected_hit == actual_hit);
+            if (!expected_hit) continue;
+
+            assert(expected.t == actual.t);
+        }
+    }
+
+    std::remove(FILE_NAME.c_str());
+}
+
+void test_rejects_other_files() {
+    {
+        std::ofstream(FILE_NAME) << "objects: []\n";
+        assert(!SceneFile::is_scene_file(FILE_NAME));
+
+        bool threw = false;
+        try {
+            SceneFile::load(FILE_NAME);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    std::remove(FILE_NAME.c_str());
+}
+
+// Writes the scene with `corrupt` applied to its nodes, and checks loading
+// it fails.
+template<typename F>
+void assert_rejects_corrupt_nodes(F corrupt) {
+    {
+        const HittableList objs = scene_objects();
+        const CompiledScene compiled(objs.objs);
+        SceneFile::write(FILE_NAME, compiled, CameraBuilder());
+
+        std::string bytes;
+        {
+            std::ifstream in(FILE_NAME, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), {});
+        }
+        const auto nodes = compiled.nodes();
+        const size_t start = bytes.find(std::string(reinterpret_cast<const char*>(nodes.data()), nodes.size_bytes()));
+        assert(start != std::string::npos);
+
+        std::vector<CompiledScene::Node> patched(nodes.begin(), nodes.end());
+        corrupt(patched);
+        bytes.replace(start, nodes.size_bytes(), reinterpret_cast<const char*>(patched.data()), nodes.size_bytes());
+        std::ofstream(FILE_NAME, std::ios::binary) << bytes;
+
+        bool threw = false;
+        try {
+            SceneFile::load(FILE_NAME);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    std::remove(FILE_NAME.c_str());
+}
+
+void test_rejects_corrupt_nodes() {
+    const auto interior = [](const CompiledScene::Node &node) { return node.count == 0 && node.offset != 0; };
+
+    // Primitives past the end of their array.
+    assert_rejects_corrupt_nodes([](auto &nodes) {
+        std::find_if(nodes.begin(), nodes.end(), [](const auto &node) { return node.count > 0; })->offset = 1u << 30;
+    });
+    // A split axis past z, which traversal would index a ray direction with.
+    assert_rejects_corrupt_nodes([&](auto &nodes) { std::find_if(nodes.begin(), nodes.end(), interior)->axis = 3; });
+    // A right child out of range.
+    assert_rejects_corrupt_nodes([&](auto &nodes) { std::find_if(nodes.begin(), nodes.end(), interior)->offset = nodes.size(); });
+    // A left child whose right child is its parent. Offset 0 marks an empty
+    // leaf, so the parent mustn't be the root.
+    assert_rejects_corrupt_nodes([&](auto &nodes) {
+        for (size_t i = 2; i < nodes.size(); i++) {
+            if (interior(nodes[i - 1]) && interior(nodes[i])) {
+                nodes[i].offset = i - 1;
+                return;
+            }
+        }
+        assert(false);
+    });
+}
+
+int main() {
+    test_round_trip();
+    test_copy();
+    test_rejects_other_files();
+    test_rejects_corrupt_nodes();
+}
@@ -140,7 +140,7 @@ void test_scene() {
         scene.add_material(metal);
         scene.add_material(std::make_shared<Dielectric>(0.5));
 
-        scene.add_object(std::make_shared<Sphere>(Point3<double>(), Point3<double>(0, 0, 1), 10.0, metal));
+        scene.add_object(std::make_shared<Sphere>(Point3<real>(), Point3<real>(0, 0, 1), 10.0, metal));
 
         YAML::Node encoding_node = YAML::convert<Scene>::encode(scene);
         YAML::Emitter out;
@@ -0,0 +1,82 @@
+#include "transform.hpp"
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "serialization.hpp"
+#include "test_util.hpp"
+#include "yaml-cpp/node/parse.h"
+
+bool near(const Vec3<real> &a, const Vec3<real> &b) {
+    return (a - b).length() < tolerance;
+}
+
+void test_round_trip() {
+    {
+        const Transform xf(Vec3<real>(1, 2, 3), Vec3<real>(10, 20, 30), Vec3<real>(2, 3, 4));
+        const Point3<real> p(0.5, -1.5, 2.0);
+
+        assert(near(xf.point_to_object(xf.point_to_world(p)), p));
+        assert(near(xf.vector_to_object(xf.vector_to_world(Vec3<real>(p))), Vec3<real>(p)));
+    }
+}
+
+void test_rotate_y() {
+    {
+        // Matches RotateY: (x, z) -> (cos x + sin z, -sin x + cos z)
+        const Transform xf = Transform::rotate_y(90);
+        const auto p = xf.point_to_world(Point3<real>(1, 0, 0));
+
+        assert(near(p, Vec3<real>(0, 0, -1)));
+    }
+}
+
+void test_normal() {
+    {
+        // Normals stay perpendicular to surfaces under non-uniform scale.
+        const Transform xf(Vec3<real>(), Vec3<real>(0, 0, 45), Vec3<real>(1, 4, 1));
+        const Vec3<real> tangent(1, -1, 0);
+        const Vec3<real> normal(1, 1, 0);
+
+        const auto world_tangent = xf.vector_to_world(tangent);
+        const auto world_normal = xf.normal_to_world(normal);
+
+        assert(std::fabs(dot(world_tangent, world_normal)) < tolerance);
+    }
+}
+
+void test_translate() {
+    {
+        const Transform xf = Transform::translate(Vec3<real>(1, 2, 3));
+
+        assert(near(xf.point_to_world(Point3<real>()), Vec3<real>(1, 2, 3)));
+        assert(near(xf.vector_to_world(Vec3<real>(1, 0, 0)), Vec3<real>(1, 0, 0)));
+    }
+}
+
+void test_decode() {
+    {
+        const Transform xf = YAML::Load("{translate: [1, 2, 3], scale: 2}").as<Transform>();
+
+        assert(xf.translation().x() == 1.0);
+        assert(xf.scale().z() == 2.0);
+    }
+
+    for (const char *scale : { "0", "[1, 0, 1]" }) {
+        bool threw = false;
+        try {
+            YAML::Load(std::string("{scale: ") + scale + "}").as<Transform>();
+        } catch (const std::runtime_error &err) {
+            threw = std::string(err.what()).starts_with("Invalid transform scale");
+        }
+        assert(threw);
+    }
+}
+
+int main() {
+    test_round_trip();
+    test_rotate_y();
+    test_normal();
+    test_translate();
+    test_decode();
+}
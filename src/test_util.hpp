@@ -1,4 +1,10 @@
 #include <iostream>
+#include <type_traits>
+#include "util.hpp"
+
+// Tolerance for results of the tracing core, looser when it is built with
+// -DRT_FLOAT32.
+constexpr real tolerance = std::is_same_v<real, float> ? 1e-4 : 1e-9;
 
 template<typename T>
 void assert_eq(T a, T b) {
@@ -132,7 +132,7 @@ void test_div() {
         // Test Vec<int> / double
         const Vec3<int> a(1, 2, 3);
         const auto b =  a / 2;
-        const Vec3<double> expected(1 / 2.0, 2 / 2.0, 3 / 2.0);
+        const Vec3<real> expected(1 / 2.0, 2 / 2.0, 3 / 2.0);
         assert_eq(b, expected);
     }
 
@@ -199,8 +199,8 @@ void test_length() {
         const auto len_sqr = a.length_sqr();
         const auto len = a.length();
 
-        const double expected_len_sqr = 225.0;
-        const double expected_len = 15.0;
+        const real expected_len_sqr = 225.0;
+        const real expected_len = 15.0;
 
         assert_eq(len_sqr, expected_len_sqr);
         assert_eq(len, expected_len);
@@ -1,4 +1,5 @@
 #pragma once
+#include "arena.hpp"
 #include "color.hpp"
 #include "vec3.hpp"
 #include "point3.hpp"
@@ -11,29 +12,30 @@ class Texture {
 public:
     virtual ~Texture() = default;
 
-    virtual Color value(double u, double v, const Point3<double>& p) const = 0;
+    virtual Color value(real u, real v, const Point3<real>& p) const = 0;
 };
 
 class SolidColorTexture : public Texture {
 public:
     SolidColorTexture(const Color &color) : color_(color) {}
-    SolidColorTexture(double r, double g, double b) : color_(r, g, b) {}
+    SolidColorTexture(real r, real g, real b) : color_(r, g, b) {}
 
-    Color value(double u, double v, const Point3<double>& p) const override { return color_; }
+    Color value(real u, real v, const Point3<real>& p) const override { return color_; }
 
 private:
     Color color_;
     friend struct YAML::convert<std::shared_ptr<SolidColorTexture>>;
+    friend class SceneFile;
 };
 
 class CheckerTexture : public Texture {
 public:
-    CheckerTexture(double scale, std::shared_ptr<Texture> even, std::shared_ptr<Texture> odd) : 
+    CheckerTexture(real scale, std::shared_ptr<Texture> even, std::shared_ptr<Texture> odd) : 
         scale_(scale), inv_scale_(1.0 / scale), even_(even), odd_(odd) {}
-    CheckerTexture(double scale, Color even, Color odd) : 
-        CheckerTexture(scale, std::make_shared<SolidColorTexture>(even), std::make_shared<SolidColorTexture>(odd)) {}
+    CheckerTexture(real scale, Color even, Color odd) : 
+        CheckerTexture(scale, make_arena_shared<SolidColorTexture>(even), make_arena_shared<SolidColorTexture>(odd)) {}
 
-    Color value(double u, double v, const Point3<double>& p) const override {
+    Color value(real u, real v, const Point3<real>& p) const override {
         const auto x_int = int(std::floor(inv_scale_ * p.x()));
         const auto y_int = int(std::floor(inv_scale_ * p.y()));
         const auto z_int  = int(std::floor(inv_scale_ * p.z()));
@@ -44,18 +46,19 @@ public:
     }
 
 private:
-    double scale_;
-    double inv_scale_;
+    real scale_;
+    real inv_scale_;
     std::shared_ptr<Texture> even_;
     std::shared_ptr<Texture> odd_;
     friend struct YAML::convert<std::shared_ptr<CheckerTexture>>;
+    friend class SceneFile;
 };
 
 class ImageTexture : public Texture {
 public:
     ImageTexture(const char *file_name) : file_name_(file_name), image_(file_name) {}
 
-    Color value(double u, double v, const Point3<double>& p) const override {
+    Color value(real u, real v, const Point3<real>& p) const override {
         if (image_.height() <= 0) return Color(0, 1, 1);
 
         u = Interval(0, 1).clamp(u);
@@ -73,13 +76,14 @@ private:
     std::string file_name_;
     RTWImage image_;
     friend struct YAML::convert<std::shared_ptr<ImageTexture>>;
+    friend class SceneFile;
 };
 
 class NoiseTexture : public Texture {
 public:
-    NoiseTexture(double scale) : scale_(scale) {}
+    NoiseTexture(real scale) : scale_(scale) {}
 
-    Color value(double u, double v, const Point3<double> &p) const override {
+    Color value(real u, real v, const Point3<real> &p) const override {
         // return Color(1.0, 1.0, 1.0) * 0.5 * (1.0 + noise_.noise(scale_ * p));
         // return Color(1.0, 1.0, 1.0) * noise_.turb(p, 7);
         return Color(0.5, 0.5, 0.5) * (1 + std::sin(scale_ * p.z() + 10 * noise_.turb(p, 7)));
@@ -87,7 +91,8 @@ public:
 
 private:
     Perlin noise_;
-    double scale_;
+    real scale_;
 
     friend struct YAML::convert<std::shared_ptr<NoiseTexture>>;
+    friend class SceneFile;
 };
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <thread>
 #include <mutex>
 #include <optional>
+#include <vector>
+
+#include "cpu_count.hpp"
+#include "numa.hpp"
+#include "trace.hpp"
 
 class TaskGenerator {
 public:
@@ -15,50 +23,67 @@ public:
 
 class ThreadPool {
 public:
-    ThreadPool(TaskGenerator& generator,  size_t num_threads = std::thread::hardware_concurrency()) : num_threads(num_threads), generator(generator) {
+    // With `pin`, worker `i` is pinned as by Numa::pin_worker.
+    ThreadPool(TaskGenerator& generator,  size_t num_threads = CpuCount::get().count, bool pin = false) : num_threads(num_threads), generator(generator), running_(num_threads) {
         // Spawn worker threads
         for (size_t i = 0; i < num_threads; i++) {
-            workers.emplace_back([this] {
+            workers.emplace_back([this, i, pin] {
+                if (pin) Numa::pin_worker(i);
+                Trace::name_thread(std::format("worker {}", i));
                 while (true) {
                     std::function<void()> task;
 
-                    { 
+                    {
+                        const auto waiting = Trace::now();
                         std::unique_lock<std::mutex> lock(task_mutex);
+                        Trace::complete("wait task_mutex", "lock", waiting, Trace::now());
 
                         std::optional<std::function<void()>> task_opt = this->generator.next();
                         if (task_opt.has_value()) {
                             task = task_opt.value();
                         } else {
-                            return;
+                            break;
                         }
                     }
 
                     task();
+                    count_.fetch_add(1, std::memory_order_relaxed);
+                }
 
-                    {
-                        std::unique_lock<std::mutex> lock(counter_mutex);
-                        count_++;
-                    }
+                std::unique_lock<std::mutex> lock(done_mutex);
+                if (--running_ == 0) {
+                    done_cv.notify_all();
                 }
             });
         }
     }
 
     ~ThreadPool() {
-        for (auto& worker : workers) {
-            worker.join();
-        }
+        kill();
     }
 
-    size_t count() {
-        std::unique_lock<std::mutex> lock(counter_mutex);
-        return count_;
+    size_t count() const {
+        return count_.load(std::memory_order_relaxed);
     }
 
+    // False once every task has been handed out, though some may still be
+    // running; see `wait`.
     bool has_next() {
         return generator.has_next();
     }
 
+    // Returns once every task has finished, calling `on_progress` every
+    // `interval` until then.
+    template<typename Rep, typename Period>
+    void wait(const std::function<void()> &on_progress, std::chrono::duration<Rep, Period> interval) {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        while (!done_cv.wait_for(lock, interval, [this] { return running_ == 0; })) {
+            lock.unlock();
+            on_progress();
+            lock.lock();
+        }
+    }
+
     void kill() {
         for (auto& worker : workers) {
             worker.join();
@@ -67,9 +92,8 @@ public:
         workers.clear();
     }
 
-    double progress() { 
-        std::unique_lock lock(counter_mutex);
-        return generator.progress(count_); 
+    double progress() const {
+        return generator.progress(count());
     }
 
     size_t num_threads;
@@ -79,6 +103,79 @@ private:
     std::vector<std::thread> workers;
     std::mutex task_mutex;
     TaskGenerator& generator;
-    std::mutex counter_mutex;
-    size_t count_ = 0;
+    std::atomic<size_t> count_ = 0;
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    size_t running_;    // Workers that haven't run out of tasks.
+};
+
+// Worker threads that outlive a single job. `run` hands the workers a
+// generator and returns once all of its tasks have finished, so a server
+// can render job after job without spawning threads each time.
+class PersistentThreadPool {
+public:
+    PersistentThreadPool(size_t num_threads = CpuCount::get().count, bool pin = false) : num_threads(num_threads) {
+        for (size_t i = 0; i < num_threads; i++) {
+            workers.emplace_back([this, i, pin] {
+                if (pin) Numa::pin_worker(i);
+                Trace::name_thread(std::format("worker {}", i));
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    work_cv.wait(lock, [this] { return stop || (generator && generator->has_next()); });
+                    if (stop) return;
+
+                    std::optional<std::function<void()>> task = generator->next();
+                    active++;
+                    lock.unlock();
+
+                    if (task.has_value()) {
+                        task.value()();
+                    }
+
+                    const auto waiting = Trace::now();
+                    lock.lock();
+                    Trace::complete("wait mutex", "lock", waiting, Trace::now());
+                    active--;
+                    if (!generator->has_next() && active == 0) {
+                        done_cv.notify_all();
+                    }
+                }
+            });
+        }
+    }
+
+    ~PersistentThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stop = true;
+        }
+        work_cv.notify_all();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    PersistentThreadPool(const PersistentThreadPool &) = delete;
+    PersistentThreadPool& operator=(const PersistentThreadPool &) = delete;
+
+    // Runs every task of `gen` on the workers. Only one job runs at a time.
+    void run(TaskGenerator& gen) {
+        std::unique_lock<std::mutex> lock(mutex);
+        generator = &gen;
+        work_cv.notify_all();
+
+        done_cv.wait(lock, [this] { return !generator->has_next() && active == 0; });
+        generator = nullptr;
+    }
+
+    size_t num_threads;
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_cv, done_cv;
+    TaskGenerator* generator = nullptr;
+    size_t active = 0;
+    bool stop = false;
 };
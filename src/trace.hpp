@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Timeline of a run in the Chrome trace event format, for chrome://tracing or
+// ui.perfetto.dev. Nothing is recorded until `start`; until then a scope
+// costs a relaxed load. Events are kept in memory and written at the end.
+class Trace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static void start() {
+        epoch_ = Clock::now();
+        enabled_ = true;
+    }
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    static Clock::time_point now() { return enabled() ? Clock::now() : Clock::time_point(); }
+
+    // Records an event spanning [begin, end] on the calling thread. `args` is
+    // the body of a JSON object, e.g. `"rays": 10`.
+    static void complete(const char *name, const char *category, Clock::time_point begin, Clock::time_point end, std::string args = {}) {
+        if (!enabled()) return;
+
+        Event event{ name, category, thread_id(), micros(begin), micros(end) - micros(begin), std::move(args) };
+        std::lock_guard lock(mutex_);
+        events_.push_back(std::move(event));
+    }
+
+    // Labels the calling thread in the timeline.
+    static void name_thread(std::string name) {
+        if (!enabled()) return;
+
+        const uint32_t tid = thread_id();
+        std::lock_guard lock(mutex_);
+        thread_names_[tid] = std::move(name);
+    }
+
+    static std::ostream& write(std::ostream &out) {
+        std::lock_guard lock(mutex_);
+
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        bool first = true;
+        for (const auto &[tid, name] : thread_names_) {
+            out << (first ? "" : ",\n") << std::format("{{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}", tid, escape(name));
+            first = false;
+        }
+        for (const auto &event : events_) {
+            out << (first ? "" : ",\n") << std::format("{{\"ph\": \"X\", \"name\": \"{}\", \"cat\": \"{}\", \"pid\": 1, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {{{}}}}}",
+                event.name, event.category, event.tid, event.ts, event.dur, event.args);
+            first = false;
+        }
+        out << "\n]}\n";
+
+        return out;
+    }
+
+    // Escapes `s` for use inside a JSON string.
+    static std::string escape(const std::string &s) {
+        std::string escaped;
+        for (const char c : s) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+        }
+        return escaped;
+    }
+
+private:
+    struct Event {
+        const char *name, *category;
+        uint32_t tid;
+        double ts, dur;     // Microseconds since `start`.
+        std::string args;
+    };
+
+    static inline std::atomic<bool> enabled_ = false;
+    static inline Clock::time_point epoch_;
+    static inline std::mutex mutex_;
+    static inline std::vector<Event> events_;
+    static inline std::map<uint32_t, std::string> thread_names_;
+    static inline std::atomic<uint32_t> next_thread_id_ = 0;
+
+    static uint32_t thread_id() {
+        static thread_local const uint32_t id = next_thread_id_++;
+        return id;
+    }
+
+    static double micros(Clock::time_point t) { return std::chrono::duration<double, std::micro>(t - epoch_).count(); }
+};
+
+// Records the lifetime of the scope as one event.
+class TraceScope {
+public:
+    TraceScope(const char *name, const char *category, std::string args = {}) : name_(name), category_(category), args_(std::move(args)), begin_(Trace::now()) {}
+    ~TraceScope() { Trace::complete(name_, category_, begin_, Trace::now(), std::move(args_)); }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope& operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_, *category_;
+    std::string args_;
+    Trace::Clock::time_point begin_;
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include "bbox.hpp"
+#include "point3.hpp"
+#include "util.hpp"
+#include "vec3.hpp"
+
+// Affine object-to-world transform. Applied as scale, then rotation about X, Y
+// and Z (in degrees), then translation.
+class Transform {
+public:
+    Transform() : Transform(Vec3<real>(), Vec3<real>(), Vec3<real>(1.0, 1.0, 1.0)) {}
+
+    Transform(const Vec3<real> &translation, const Vec3<real> &rotation, const Vec3<real> &scale) :
+        translation_(translation), rotation_(rotation), scale_(scale)
+    {
+        const real rx = degrees_to_radians(rotation_.x());
+        const real ry = degrees_to_radians(rotation_.y());
+        const real rz = degrees_to_radians(rotation_.z());
+
+        const real rot_x[3][3] = {{1, 0, 0}, {0, std::cos(rx), -std::sin(rx)}, {0, std::sin(rx), std::cos(rx)}};
+        const real rot_y[3][3] = {{std::cos(ry), 0, std::sin(ry)}, {0, 1, 0}, {-std::sin(ry), 0, std::cos(ry)}};
+        const real rot_z[3][3] = {{std::cos(rz), -std::sin(rz), 0}, {std::sin(rz), std::cos(rz), 0}, {0, 0, 1}};
+
+        real rot_yx[3][3], rot[3][3];
+        multiply(rot_y, rot_x, rot_yx);
+        multiply(rot_z, rot_yx, rot);
+
+        // M = R * S and M^-1 = S^-1 * R^T
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                m_[i][j] = rot[i][j] * scale_[j];
+                inv_[i][j] = rot[j][i] / scale_[i];
+            }
+        }
+    }
+
+    static Transform translate(const Vec3<real> &offset) { return Transform(offset, Vec3<real>(), Vec3<real>(1.0, 1.0, 1.0)); }
+    static Transform rotate_y(real degrees) { return Transform(Vec3<real>(), Vec3<real>(0.0, degrees, 0.0), Vec3<real>(1.0, 1.0, 1.0)); }
+
+    Point3<real> point_to_world(const Point3<real> &p) const { return Point3<real>(apply(m_, Vec3<real>(p)) + translation_); }
+    Vec3<real> vector_to_world(const Vec3<real> &v) const { return apply(m_, v); }
+    // Normals transform by the inverse transpose.
+    Vec3<real> normal_to_world(const Vec3<real> &n) const { return apply_transposed(inv_, n); }
+
+    Point3<real> point_to_object(const Point3<real> &p) const { return Point3<real>(apply(inv_, Vec3<real>(p) - translation_)); }
+    Vec3<real> vector_to_object(const Vec3<real> &v) const { return apply(inv_, v); }
+
+    BBox3 bbox_to_world(const BBox3 &bbox) const {
+        Point3<real> min(infinity, infinity, infinity);
+        Point3<real> max(-infinity, -infinity, -infinity);
+
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 2; j++) {
+                for (int k = 0; k < 2; k++) {
+                    const Point3<real> corner(
+                            i ? bbox.x.max : bbox.x.min,
+                            j ? bbox.y.max : bbox.y.min,
+                            k ? bbox.z.max : bbox.z.min);
+                    const auto tester = point_to_world(corner);
+
+                    for (int c = 0; c < 3; c++) {
+                        min[c] = std::fmin(min[c], tester[c]);
+                        max[c] = std::fmax(max[c], tester[c]);
+                    }
+                }
+            }
+        }
+
+        return BBox3(min, max);
+    }
+
+    const Vec3<real>& translation() const { return translation_; }
+    const Vec3<real>& rotation() const { return rotation_; }
+    const Vec3<real>& scale() const { return scale_; }
+
+private:
+    Vec3<real> translation_, rotation_, scale_;
+    real m_[3][3];
+    real inv_[3][3];
+
+    static Vec3<real> apply(const real m[3][3], const Vec3<real> &v) {
+        return Vec3<real>(
+                m[0][0] * v.x() + m[0][1] * v.y() + m[0][2] * v.z(),
+                m[1][0] * v.x() + m[1][1] * v.y() + m[1][2] * v.z(),
+                m[2][0] * v.x() + m[2][1] * v.y() + m[2][2] * v.z());
+    }
+
+    static Vec3<real> apply_transposed(const real m[3][3], const Vec3<real> &v) {
+        return Vec3<real>(
+                m[0][0] * v.x() + m[1][0] * v.y() + m[2][0] * v.z(),
+                m[0][1] * v.x() + m[1][1] * v.y() + m[2][1] * v.z(),
+                m[0][2] * v.x() + m[1][2] * v.y() + m[2][2] * v.z());
+    }
+
+    static void multiply(const real a[3][3], const real b[3][3], real out[3][3]) {
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                out[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+            }
+        }
+    }
+};
@@ -1,19 +1,48 @@
 #pragma once
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <random>
 
+// Scalar type of the tracing core. Build with -DRT_FLOAT32 to trace in single
+// precision.
+#ifdef RT_FLOAT32
+using real = float;
+#else
+using real = double;
+#endif
+
 // Constants
-constexpr double infinity = std::numeric_limits<double>::infinity();
-constexpr double pi = 3.1415926535897932385;
+constexpr real infinity = std::numeric_limits<real>::infinity();
+constexpr real pi = 3.1415926535897932385;
 
 // Utility Functions
-inline double degrees_to_radians(double degrees) { return degrees * pi / 180.0; }
-inline double radians_to_degrees(double radians) { return radians * 180.0 / pi; }
+inline real degrees_to_radians(real degrees) { return degrees * pi / 180; }
+inline real radians_to_degrees(real radians) { return radians * 180 / pi; }
+
+// Generator behind `random_double`. Every thread has its own, and renders
+// reseed it per chunk so images don't depend on which thread ran a chunk.
+inline std::mt19937& random_generator() {
+    static thread_local std::mt19937 generator;
+    return generator;
+}
+
+// SplitMix64 finalizer, turns related inputs (seed, chunk index) into
+// unrelated seeds.
+inline uint64_t mix_seed(uint64_t seed, uint64_t stream) {
+    uint64_t z = seed + 0x9e3779b97f4a7c15 * (stream + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+inline void seed_random(uint64_t seed) {
+    random_generator().seed(static_cast<uint32_t>(seed ^ (seed >> 32)));
+}
 
 inline double random_double() {
-    static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    static std::mt19937 generator;
-    return distribution(generator);
+    static thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    return distribution(random_generator());
 }
 
 inline double random_double(double min, double max) {
@@ -1,8 +1,10 @@
 #pragma once
+#include "simd.hpp"
 #include "util.hpp"
 #include <cmath>
 #include <cstddef>
 #include <iostream>
+#include <type_traits>
 
 template <typename T>
 struct Point3;
@@ -11,22 +13,36 @@ struct Color;
 
 template <typename T>
 struct Vec3 {
-    T elem[3];
+    vec3_storage_t<T> elem;
 
     Vec3() : elem{0, 0, 0} { }
 
     Vec3(T x, T y, T z) : elem{x, y, z} { }
     Vec3(const Point3<T> &p) : elem{p.x(), p.y(), p.z()} {}
     Vec3(const Color &c);
+    explicit Vec3(simd::lanes_t<T> v) : elem(v) {}
+
+    simd::lanes_t<T> lanes() const { return elem; }
 
     inline T x() const { return elem[0]; }
     inline T y() const { return elem[1]; }
     inline T z() const { return elem[2]; }
 
-    Vec3<T> operator-() const { return Vec3<T>(-elem[0], -elem[1], -elem[2]); }
+    Vec3<T> operator-() const {
+        if constexpr (simd::enabled<T, T>) {
+            return Vec3<T>(-lanes());
+        }
+
+        return Vec3<T>(-elem[0], -elem[1], -elem[2]);
+    }
 
 
     Vec3<T>& operator-=(const Vec3<T> &other) {
+        if constexpr (simd::enabled<T, T>) {
+            elem -= other.elem;
+            return *this;
+        }
+
         elem[0] -= other.x();
         elem[1] -= other.y();
         elem[2] -= other.z();
@@ -35,6 +51,11 @@ struct Vec3 {
     }
 
     Vec3<T>& operator+=(const Vec3<T> &other) {
+        if constexpr (simd::enabled<T, T>) {
+            elem += other.elem;
+            return *this;
+        }
+
         elem[0] += other.x();
         elem[1] += other.y();
         elem[2] += other.z();
@@ -43,6 +64,11 @@ struct Vec3 {
     }
 
     Vec3<T>& operator*=(T t) {
+        if constexpr (simd::enabled<T, T>) {
+            elem *= t;
+            return *this;
+        }
+
         elem[0] *= t;
         elem[1] *= t;
         elem[2] *= t;
@@ -50,15 +76,19 @@ struct Vec3 {
         return *this;
     }
 
-    Vec3<double>& operator/=(double t) {
+    Vec3<T>& operator/=(T t) {
         return *this *= (1 / t);
     }
 
-    double length_sqr() const {
+    real length_sqr() const {
+        if constexpr (simd::enabled<T, T>) {
+            return simd::sum3<T>(lanes() * lanes());
+        }
+
         return this->x() * this->x() + this->y() * this->y() + this->z() * this->z();
     }
 
-    double length() const {
+    real length() const {
         return std::sqrt(length_sqr());
     }
 
@@ -70,12 +100,12 @@ struct Vec3 {
         return elem[i];
     }
 
-    static Vec3<double> random() {
-        return Vec3<double>(random_double(), random_double(), random_double());
+    static Vec3<T> random() {
+        return Vec3<T>(random_double(), random_double(), random_double());
     }
 
-    static Vec3<double> random(double min, double max) {
-        return Vec3<double>(random_double(min, max), random_double(min, max), random_double(min, max));
+    static Vec3<T> random(T min, T max) {
+        return Vec3<T>(random_double(min, max), random_double(min, max), random_double(min, max));
     }
 
     bool near_zero() const {
@@ -91,31 +121,52 @@ inline std::ostream& operator<<(std::ostream& out, const Vec3<T>& v) {
 
 template<typename U, typename V>
 inline Vec3<decltype(U() - V())> operator-(const Vec3<U> &u, const Vec3<V> &v) {
+    if constexpr (simd::enabled<U, V>) {
+        return Vec3<U>(u.lanes() - v.lanes());
+    }
+
     return Vec3(u.x() - v.x(), u.y() - v.y(), u.z() - v.z());
 }
 
 template<typename U, typename V>
 inline Vec3<decltype(U() + V())> operator+(const Vec3<U> &u, const Vec3<V> &v) {
+    if constexpr (simd::enabled<U, V>) {
+        return Vec3<U>(u.lanes() + v.lanes());
+    }
+
     return Vec3(u.x() + v.x(), u.y() + v.y(), u.z() + v.z());
 }
 
+// Element type of a vector scaled by a scalar. Floating-point vectors keep
+// their precision so that literals don't promote a float build to double.
 template<typename V, typename T>
-inline Vec3<decltype(V() * T())> operator*(T t, const Vec3<V> &v) {
-    return Vec3(v.x() * t, v.y() * t, v.z() * t);
+using scaled_t = std::conditional_t<std::is_floating_point_v<V>, V, decltype(V() * T())>;
+
+template<typename V, typename T>
+inline Vec3<scaled_t<V, T>> operator*(T t, const Vec3<V> &v) {
+    if constexpr (simd::enabled<V, scaled_t<V, T>>) {
+        return Vec3<V>(v.lanes() * static_cast<V>(t));
+    }
+
+    return Vec3<scaled_t<V, T>>(v.x() * t, v.y() * t, v.z() * t);
 }
 
 template<typename V, typename T>
-inline Vec3<decltype(V() * T())> operator*(const Vec3<V> &v, T t) {
+inline Vec3<scaled_t<V, T>> operator*(const Vec3<V> &v, T t) {
     return t * v;
 }
 
-template<typename V>
-inline Vec3<double> operator/(const Vec3<V> &v, double t) {
-    return (1 / t) *  v;
+template<typename V, typename T>
+inline Vec3<scaled_t<V, real>> operator/(const Vec3<V> &v, T t) {
+    return (scaled_t<V, real>(1) / t) * v;
 }
 
 template<typename U, typename V>
 inline decltype(U() * V()) dot(const Vec3<U> &u, const Vec3<V> &v) {
+    if constexpr (simd::enabled<U, V>) {
+        return simd::sum3<U>(u.lanes() * v.lanes());
+    }
+
     return u.x() * v.x() + u.y() * v.y() + u.z() * v.z();
 }
 
@@ -126,6 +177,12 @@ inline bool operator==(const Vec3<T> &u, const Vec3<T> &v) {
 
 template<typename U, typename V>
 inline Vec3<decltype(U() * V())> cross(const Vec3<U> &u, const Vec3<V> &v) {
+    if constexpr (simd::enabled<U, V>) {
+        const auto a = u.lanes();
+        const auto b = v.lanes();
+        return Vec3<U>(simd::yzx<U>(a) * simd::zxy<U>(b) - simd::zxy<U>(a) * simd::yzx<U>(b));
+    }
+
     return Vec3<decltype(U() * V())>(
             u.y() * v.z() - u.z() * v.y(),
             u.z() * v.x() - u.x() * v.z(),
@@ -137,7 +194,7 @@ auto normalize(Vec3<T> v) { return v / v.length(); }
 
 inline auto random_unit_vector() {
     while (true) {
-        auto p = Vec3<double>::random(-1, 1);
+        auto p = Vec3<real>::random(-1, 1);
         auto length_sqr = p.length_sqr();
         if (1.0e-160 < length_sqr && length_sqr <= 1.0) {
             return p / std::sqrt(length_sqr);
@@ -145,8 +202,8 @@ inline auto random_unit_vector() {
     }
 }
 
-inline auto random_on_hemisphere(const Vec3<double> &normal) {
-    Vec3<double> on_unit_sphere = random_unit_vector();
+inline auto random_on_hemisphere(const Vec3<real> &normal) {
+    Vec3<real> on_unit_sphere = random_unit_vector();
     if (dot(on_unit_sphere, normal) > 0.0) {
         return on_unit_sphere;
     } 
@@ -156,7 +213,7 @@ inline auto random_on_hemisphere(const Vec3<double> &normal) {
 
 inline auto random_on_unit_disk() {
     while (true) {
-        const auto p = Vec3<double>(random_double(-1.0, 1.0), random_double(-1.0, 1.0), 0.0);
+        const auto p = Vec3<real>(random_double(-1.0, 1.0), random_double(-1.0, 1.0), 0.0);
         if (p.length_sqr() < 1) { 
             return p; 
         }
@@ -169,7 +226,7 @@ inline Vec3<decltype(V() * N())> reflect(const Vec3<V> &v, const Vec3<N> n) {
 }
 
 template<typename V, typename N>
-inline auto refract(const Vec3<V> &v, const Vec3<N> &n, double etai_over_etat) {
+inline auto refract(const Vec3<V> &v, const Vec3<N> &n, real etai_over_etat) {
     const auto cos_theta = std::fmin(dot(-v, n), 1.0);
     const auto r_out_perp = etai_over_etat * (v + cos_theta * n);
     const auto r_out_parallel = -std::sqrt(std::fabs(1.0 - r_out_perp.length_sqr())) * n;